@@ -0,0 +1,326 @@
+/*
+ * gexiv2-batch-reader.cpp
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-batch-reader.h"
+#include "gexiv2-metadata.h"
+#include "gexiv2-metadata-private.h"
+#include "gexiv2-startup.h"
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+struct _GExiv2BatchResult {
+    gint ref_count;
+    guint index;
+    gchar* path;
+    GError* error;
+    GExiv2Metadata* metadata;
+    GHashTable* tags;
+};
+
+G_DEFINE_BOXED_TYPE(GExiv2BatchResult, gexiv2_batch_result, gexiv2_batch_result_ref, gexiv2_batch_result_unref)
+
+GExiv2BatchResult* gexiv2_batch_result_ref(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    g_atomic_int_inc(&self->ref_count);
+
+    return self;
+}
+
+void gexiv2_batch_result_unref(GExiv2BatchResult* self) {
+    g_return_if_fail(self != nullptr);
+
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+
+    g_free(self->path);
+    g_clear_error(&self->error);
+    g_clear_object(&self->metadata);
+    g_clear_pointer(&self->tags, g_hash_table_unref);
+    g_free(self);
+}
+
+guint gexiv2_batch_result_get_index(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, 0);
+
+    return self->index;
+}
+
+const gchar* gexiv2_batch_result_get_path(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return self->path;
+}
+
+const GError* gexiv2_batch_result_get_error(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return self->error;
+}
+
+GExiv2Metadata* gexiv2_batch_result_get_metadata(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return self->metadata;
+}
+
+GHashTable* gexiv2_batch_result_get_tags(GExiv2BatchResult* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return self->tags;
+}
+
+namespace {
+// A file waiting for a worker
+struct Job {
+    guint index;
+    gchar* path;
+    GFile* file;
+};
+
+void job_free(Job* job) {
+    g_free(job->path);
+    g_clear_object(&job->file);
+    g_free(job);
+}
+} // namespace
+
+struct _GExiv2BatchReader {
+    GObject parent_instance;
+
+    GExiv2OpenFlags flags;
+    // Resolved once here rather than by every worker for every file
+    detail::TagRequest* tags;
+    // Set if the tag names were invalid, handed out with every result
+    GError* tags_error;
+    guint max_pending;
+
+    GThreadPool* pool;
+
+    // Protects everything below
+    GMutex lock;
+    // Signalled whenever a result is taken or the reader goes away
+    GCond slot_free;
+    // Signalled whenever a result is queued or the reader is closed
+    GCond result_ready;
+    // Results waiting to be taken
+    GQueue results;
+    // Results that are being read or wait to be taken
+    guint pending;
+    guint added;
+    guint taken;
+    gboolean closed;
+    gboolean disposing;
+};
+
+G_DEFINE_TYPE(GExiv2BatchReader, gexiv2_batch_reader, G_TYPE_OBJECT)
+
+// Metadata object of each worker thread when only tags are read, reused for every file
+static GPrivate worker_metadata = G_PRIVATE_INIT(g_object_unref);
+
+static void gexiv2_batch_reader_finalize(GObject* object) {
+    auto* self = GEXIV2_BATCH_READER(object);
+
+    // Wake up workers waiting for room, they drop whatever is left
+    g_mutex_lock(&self->lock);
+    self->disposing = TRUE;
+    g_cond_broadcast(&self->slot_free);
+    g_mutex_unlock(&self->lock);
+
+    g_thread_pool_free(self->pool, FALSE, TRUE);
+
+    while (auto* result = static_cast<GExiv2BatchResult*>(g_queue_pop_head(&self->results)))
+        gexiv2_batch_result_unref(result);
+
+    delete self->tags;
+    g_clear_error(&self->tags_error);
+    g_mutex_clear(&self->lock);
+    g_cond_clear(&self->slot_free);
+    g_cond_clear(&self->result_ready);
+
+    G_OBJECT_CLASS(gexiv2_batch_reader_parent_class)->finalize(object);
+}
+
+static void gexiv2_batch_reader_class_init(GExiv2BatchReaderClass* klass) {
+    GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+
+    gobject_class->finalize = gexiv2_batch_reader_finalize;
+}
+
+static void gexiv2_batch_reader_init(GExiv2BatchReader* self) {
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->slot_free);
+    g_cond_init(&self->result_ready);
+    g_queue_init(&self->results);
+}
+
+static gboolean gexiv2_batch_reader_open(GExiv2BatchReader* self, GExiv2Metadata* metadata, Job* job, GError** error) {
+    if (job->path != nullptr)
+        return gexiv2_metadata_open_path_with_flags(metadata, job->path, self->flags, error);
+
+    g_autoptr(GFileInputStream) stream = g_file_read(job->file, nullptr, error);
+    if (stream == nullptr)
+        return FALSE;
+
+    return gexiv2_metadata_from_stream_with_flags(metadata, G_INPUT_STREAM(stream), self->flags, error);
+}
+
+static void gexiv2_batch_reader_work(gpointer data, gpointer user_data) {
+    auto* job = static_cast<Job*>(data);
+    auto* self = static_cast<GExiv2BatchReader*>(user_data);
+
+    // Wait for room before reading, so that results in flight count against the limit as well
+    g_mutex_lock(&self->lock);
+    while (self->pending >= self->max_pending && !self->disposing)
+        g_cond_wait(&self->slot_free, &self->lock);
+    auto disposing = self->disposing;
+    if (!disposing)
+        self->pending++;
+    g_mutex_unlock(&self->lock);
+
+    if (disposing) {
+        job_free(job);
+
+        return;
+    }
+
+    auto* result = g_new0(GExiv2BatchResult, 1);
+    result->ref_count = 1;
+    result->index = job->index;
+    result->path = job->path != nullptr ? g_strdup(job->path) : g_file_get_uri(job->file);
+
+    if (self->tags == nullptr) {
+        result->metadata = gexiv2_metadata_new();
+        if (!gexiv2_batch_reader_open(self, result->metadata, job, &result->error))
+            g_clear_object(&result->metadata);
+    } else {
+        auto* metadata = static_cast<GExiv2Metadata*>(g_private_get(&worker_metadata));
+        if (metadata == nullptr) {
+            metadata = gexiv2_metadata_new();
+            g_private_set(&worker_metadata, metadata);
+        }
+
+        if (self->tags_error != nullptr)
+            result->error = g_error_copy(self->tags_error);
+        else if (gexiv2_batch_reader_open(self, metadata, job, &result->error))
+            result->tags = detail::get_tags_batch(metadata, *self->tags, &result->error);
+
+        // Only keep the buffers around until the next file
+        gexiv2_metadata_reset(metadata);
+    }
+
+    job_free(job);
+
+    g_mutex_lock(&self->lock);
+    g_queue_push_tail(&self->results, result);
+    g_cond_signal(&self->result_ready);
+    g_mutex_unlock(&self->lock);
+}
+
+GExiv2BatchReader* gexiv2_batch_reader_new(GExiv2OpenFlags flags,
+                                           const gchar* const* tags,
+                                           guint max_threads,
+                                           guint max_pending) {
+    // The XMP toolkit has to be set up before the workers use it concurrently
+    gexiv2_initialize();
+
+    auto* self = GEXIV2_BATCH_READER(g_object_new(GEXIV2_TYPE_BATCH_READER, nullptr));
+
+    if (max_threads == 0)
+        max_threads = g_get_num_processors();
+
+    self->flags = flags;
+    if (tags != nullptr) {
+        self->tags = new detail::TagRequest();
+        detail::resolve_tags(tags, *self->tags, &self->tags_error);
+    }
+    self->max_pending = max_pending != 0 ? max_pending : 2 * max_threads;
+    self->pool = g_thread_pool_new(gexiv2_batch_reader_work, self, static_cast<gint>(max_threads), FALSE, nullptr);
+
+    return self;
+}
+
+static void gexiv2_batch_reader_add(GExiv2BatchReader* self, gchar* path, GFile* file) {
+    g_mutex_lock(&self->lock);
+    auto closed = self->closed;
+    auto index = closed ? 0 : self->added++;
+    g_mutex_unlock(&self->lock);
+
+    if (closed) {
+        g_free(path);
+        g_clear_object(&file);
+    }
+    g_return_if_fail(!closed);
+
+    auto* job = g_new0(Job, 1);
+    job->index = index;
+    job->path = path;
+    job->file = file;
+
+    g_thread_pool_push(self->pool, job, nullptr);
+}
+
+void gexiv2_batch_reader_add_path(GExiv2BatchReader* self, const gchar* path) {
+    g_return_if_fail(GEXIV2_IS_BATCH_READER(self));
+    g_return_if_fail(path != nullptr);
+
+    gexiv2_batch_reader_add(self, g_strdup(path), nullptr);
+}
+
+void gexiv2_batch_reader_add_file(GExiv2BatchReader* self, GFile* file) {
+    g_return_if_fail(GEXIV2_IS_BATCH_READER(self));
+    g_return_if_fail(G_IS_FILE(file));
+
+    // Local files are opened by path, which reads only what is needed
+    gchar* path = g_file_get_path(file);
+    gexiv2_batch_reader_add(self, path, path == nullptr ? G_FILE(g_object_ref(file)) : nullptr);
+}
+
+void gexiv2_batch_reader_close(GExiv2BatchReader* self) {
+    g_return_if_fail(GEXIV2_IS_BATCH_READER(self));
+
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    g_cond_broadcast(&self->result_ready);
+    g_mutex_unlock(&self->lock);
+}
+
+// Hands out the oldest result and makes room for another one, with the lock held
+static GExiv2BatchResult* gexiv2_batch_reader_take(GExiv2BatchReader* self) {
+    auto* result = static_cast<GExiv2BatchResult*>(g_queue_pop_head(&self->results));
+    if (result != nullptr) {
+        self->pending--;
+        self->taken++;
+        g_cond_signal(&self->slot_free);
+    }
+
+    return result;
+}
+
+GExiv2BatchResult* gexiv2_batch_reader_next(GExiv2BatchReader* self) {
+    g_return_val_if_fail(GEXIV2_IS_BATCH_READER(self), nullptr);
+
+    // Checking for the end and waiting happen under the same lock, so that a close() from
+    // another thread in between cannot leave this waiting for a result that never comes
+    g_mutex_lock(&self->lock);
+    while (g_queue_is_empty(&self->results) && !(self->closed && self->taken == self->added))
+        g_cond_wait(&self->result_ready, &self->lock);
+    auto* result = gexiv2_batch_reader_take(self);
+    g_mutex_unlock(&self->lock);
+
+    return result;
+}
+
+GExiv2BatchResult* gexiv2_batch_reader_try_next(GExiv2BatchReader* self) {
+    g_return_val_if_fail(GEXIV2_IS_BATCH_READER(self), nullptr);
+
+    g_mutex_lock(&self->lock);
+    auto* result = gexiv2_batch_reader_take(self);
+    g_mutex_unlock(&self->lock);
+
+    return result;
+}
@@ -0,0 +1,226 @@
+/*
+ * gexiv2-batch-reader.h
+ *
+ * Reads the metadata of many files on a pool of worker threads
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_BATCH_READER_H
+#define GEXIV2_BATCH_READER_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gexiv2/gexiv2-metadata.h>
+
+G_BEGIN_DECLS
+
+#define GEXIV2_TYPE_BATCH_RESULT (gexiv2_batch_result_get_type())
+
+/**
+ * GExiv2BatchResult:
+ *
+ * The outcome of reading one file with a [class@GExiv2.BatchReader].
+ *
+ * Since: 0.17.0
+ */
+typedef struct _GExiv2BatchResult GExiv2BatchResult;
+
+GType gexiv2_batch_result_get_type(void) G_GNUC_CONST;
+
+/**
+ * gexiv2_batch_result_ref:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Returns: (transfer full): @self
+ *
+ * Since: 0.17.0
+ */
+GExiv2BatchResult* gexiv2_batch_result_ref(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_unref:
+ * @self: (transfer full): A [struct@GExiv2.BatchResult]
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_batch_result_unref(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_get_index:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Results are delivered in the order the files are finished in, which is not the order
+ * they were added in. The index tells which file a result belongs to.
+ *
+ * Returns: The position of the file among all files added to the reader, starting at 0
+ *
+ * Since: 0.17.0
+ */
+guint gexiv2_batch_result_get_index(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_get_path:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Returns: (transfer none): The path of the file, or its URI if it was added as a
+ *   [iface@Gio.File] without a local path
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_batch_result_get_path(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_get_error:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Returns: (transfer none) (nullable): Why the file could not be read, or %NULL if it was read
+ *
+ * Since: 0.17.0
+ */
+const GError* gexiv2_batch_result_get_error(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_get_metadata:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Returns: (transfer none) (nullable): The metadata of the file, if it was read and the reader
+ *   was not limited to a set of tags
+ *
+ * Since: 0.17.0
+ */
+GExiv2Metadata* gexiv2_batch_result_get_metadata(GExiv2BatchResult* self);
+
+/**
+ * gexiv2_batch_result_get_tags:
+ * @self: A [struct@GExiv2.BatchResult]
+ *
+ * Returns: (transfer none) (nullable) (element-type utf8 utf8): The values of the tags the reader
+ *   was limited to, as returned by [method@GExiv2.Metadata.get_tags_batch], if the file was read
+ *
+ * Since: 0.17.0
+ */
+GHashTable* gexiv2_batch_result_get_tags(GExiv2BatchResult* self);
+
+#define GEXIV2_TYPE_BATCH_READER (gexiv2_batch_reader_get_type())
+
+G_DECLARE_FINAL_TYPE(GExiv2BatchReader, gexiv2_batch_reader, GEXIV2, BATCH_READER, GObject)
+
+/**
+ * GExiv2BatchReader:
+ *
+ * Reads the metadata of many files on a bounded pool of worker threads.
+ *
+ * Files are added with [method@GExiv2.BatchReader.add_path] or
+ * [method@GExiv2.BatchReader.add_file], and their results are taken with
+ * [method@GExiv2.BatchReader.next]. Idle workers pick up the next file from a shared queue, so a
+ * few slow files do not hold up the others. Once the given number of results is waiting to be
+ * taken, the workers pause until [method@GExiv2.BatchReader.next] is called again, which bounds
+ * the memory used by results.
+ *
+ * ```c
+ * reader = gexiv2_batch_reader_new(GEXIV2_OPEN_EXIF, tags, 4, 16);
+ * for (i = 0; paths[i] != NULL; i++)
+ *     gexiv2_batch_reader_add_path(reader, paths[i]);
+ * gexiv2_batch_reader_close(reader);
+ *
+ * while ((result = gexiv2_batch_reader_next(reader)) != NULL) {
+ *     ...
+ *     gexiv2_batch_result_unref(result);
+ * }
+ * ```
+ *
+ * Since: 0.17.0
+ */
+
+/**
+ * gexiv2_batch_reader_new:
+ * @flags: The parts of the metadata to read, see [method@GExiv2.Metadata.open_path_with_flags]
+ * @tags: (array zero-terminated=1) (nullable): Tags to read, or %NULL for the whole metadata
+ * @max_threads: The number of worker threads, 0 for one per processor
+ * @max_pending: The number of results that may wait to be taken before the workers pause,
+ *   0 for twice the number of workers
+ *
+ * Creates a reader. gexiv2 is initialized here if that did not happen yet, so the reader
+ * should be created before any other thread uses gexiv2.
+ *
+ * With @tags, the workers only extract the values of @tags and drop the rest of the metadata,
+ * which keeps results small and lets each worker reuse one [class@GExiv2.Metadata].
+ * The names in @tags are parsed once here; if one is not a valid tag name, every result
+ * carries that error.
+ *
+ * Returns: (transfer full): A new [class@GExiv2.BatchReader]
+ *
+ * Since: 0.17.0
+ */
+GExiv2BatchReader* gexiv2_batch_reader_new(GExiv2OpenFlags flags,
+                                           const gchar* const* tags,
+                                           guint max_threads,
+                                           guint max_pending);
+
+/**
+ * gexiv2_batch_reader_add_path:
+ * @self: A [class@GExiv2.BatchReader]
+ * @path: The file to read
+ *
+ * Queues @path for reading. Must not be called after [method@GExiv2.BatchReader.close].
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_batch_reader_add_path(GExiv2BatchReader* self, const gchar* path);
+
+/**
+ * gexiv2_batch_reader_add_file:
+ * @self: A [class@GExiv2.BatchReader]
+ * @file: The file to read
+ *
+ * Queues @file for reading. Files without a local path are read through a
+ * [class@Gio.InputStream]. Must not be called after [method@GExiv2.BatchReader.close].
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_batch_reader_add_file(GExiv2BatchReader* self, GFile* file);
+
+/**
+ * gexiv2_batch_reader_close:
+ * @self: A [class@GExiv2.BatchReader]
+ *
+ * Tells the reader that no more files are going to be added, so that
+ * [method@GExiv2.BatchReader.next] can return %NULL once every file was handed out.
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_batch_reader_close(GExiv2BatchReader* self);
+
+/**
+ * gexiv2_batch_reader_next:
+ * @self: A [class@GExiv2.BatchReader]
+ *
+ * Waits for the next file to be finished.
+ *
+ * Before [method@GExiv2.BatchReader.close] was called, this blocks until another result is
+ * available, even if all files added so far were already handed out.
+ *
+ * Returns: (transfer full) (nullable): The next result, or %NULL if the reader was closed and
+ *   all results were returned
+ *
+ * Since: 0.17.0
+ */
+GExiv2BatchResult* gexiv2_batch_reader_next(GExiv2BatchReader* self);
+
+/**
+ * gexiv2_batch_reader_try_next:
+ * @self: A [class@GExiv2.BatchReader]
+ *
+ * Like [method@GExiv2.BatchReader.next], but does not wait. This allows taking results while
+ * files are still being added, so that the workers never run out of room.
+ *
+ * Returns: (transfer full) (nullable): A finished result, or %NULL if there is none right now
+ *
+ * Since: 0.17.0
+ */
+GExiv2BatchResult* gexiv2_batch_reader_try_next(GExiv2BatchReader* self);
+
+G_END_DECLS
+
+#endif /* GEXIV2_BATCH_READER_H */
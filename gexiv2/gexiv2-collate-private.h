@@ -0,0 +1,24 @@
+/*
+ * gexiv2-collate-private.h
+ *
+ * Natural sort keys for metadata keys
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_COLLATE_PRIVATE_H
+#define GEXIV2_COLLATE_PRIVATE_H
+
+#include <glib.h>
+#include <string>
+#include <string_view>
+
+namespace detail {
+// Appends the collation key of str to out. Comparing collation keys with operator< sorts
+// numbers embedded in the keys by value, e.g. "Xmp.dc.subject[2]" before "Xmp.dc.subject[10]"
+G_GNUC_INTERNAL void collate_key(std::string_view str, std::string& out);
+
+G_GNUC_INTERNAL std::string collate_key(const std::string& str);
+} // namespace detail
+
+#endif /* GEXIV2_COLLATE_PRIVATE_H */
@@ -0,0 +1,81 @@
+/*
+ * gexiv2-collate.cpp
+ *
+ * Natural sort keys for metadata keys
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-collate-private.h"
+
+namespace {
+constexpr char SUPERDIGIT = ':';
+constexpr std::string_view COLLATION_SENTINEL = "\x01\x01\x01";
+constexpr char NUM_SENTINEL = 0x2;
+
+constexpr bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Keys without digits collate as themselves, followed by the final sentinel
+constexpr bool needs_collation(std::string_view str) {
+    for (auto c : str) {
+        if (is_digit(c))
+            return true;
+    }
+
+    return false;
+}
+
+static_assert(!needs_collation("Xmp.dc.title"));
+static_assert(needs_collation("Xmp.dc.subject[1]"));
+} // namespace
+
+// Port of the NaturalCollate.vala collation key generation to C++
+// Simplified to assume that all XMP keys are ASCII and not UTF-8
+// Original source:
+// https://gitlab.gnome.org/GNOME/shotwell/-/blob/master/src/NaturalCollate.vala
+void detail::collate_key(std::string_view str, std::string& out) {
+    if (!needs_collation(str)) {
+        out.append(str);
+        out.push_back(NUM_SENTINEL);
+
+        return;
+    }
+
+    std::string_view::size_type i = 0;
+    while (i < str.size()) {
+        // As long as there are no digits, we put them from input to output
+        auto start = i;
+        while (i < str.size() && !is_digit(str[i]))
+            i++;
+        out.append(str, start, i - start);
+
+        if (i == str.size())
+            break;
+
+        // Numbers compare by value, so leading zeroes are dropped, keeping a single "0"
+        start = i;
+        while (i < str.size() && is_digit(str[i]))
+            i++;
+        while (start + 1 < i && str[start] == '0')
+            start++;
+
+        // Append the number prefixed by its length in ':'
+        out.append(COLLATION_SENTINEL);
+        out.push_back(NUM_SENTINEL);
+        out.append(i - start, SUPERDIGIT);
+        out.append(str, start, i - start);
+    }
+
+    // Add a sentinal for good measure (no idea, follows the original code)
+    out.push_back(NUM_SENTINEL);
+}
+
+std::string detail::collate_key(const std::string& str) {
+    std::string out;
+    out.reserve(str.size() + 1);
+    collate_key(str, out);
+
+    return out;
+}
@@ -1,24 +1,50 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 // SPDX-FileCopyrightText: Copyright Jens Georg <mail@jensge.org>
 #pragma once
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include <exiv2/exiv2.hpp>
 #include <gio/gio.h>
 #include <glib-object.h>
 
+#if defined(G_OS_UNIX) && defined(HAVE_GIO_UNIX)
+#include <gio/gfiledescriptorbased.h>
+#include <gio/gunixinputstream.h>
+#define GEXIV2_GIO_IO_CAN_MAP 1
+#endif
+
 namespace GExiv2 {
 
 class GioIo : public Exiv2::BasicIo {
   public:
-    GioIo(GInputStream* is)
+    // Default size of the read-ahead buffer. Exiv2's parsers issue lots of tiny reads which
+    // would otherwise each end up as a vfunc call on the underlying stream
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    GioIo(GInputStream* is, GCancellable* cancellable = nullptr, size_t buffer_size = DEFAULT_BUFFER_SIZE)
       : BasicIo()
       , _is(G_INPUT_STREAM(g_object_ref(is)))
-      , _seekable(G_SEEKABLE(_is)) {
+      , _seekable(G_SEEKABLE(_is))
+      , _cancellable(cancellable != nullptr ? G_CANCELLABLE(g_object_ref(cancellable)) : nullptr)
+      , _buffer_size(std::max(buffer_size, size_t{1})) {
+
+        GError* error = nullptr;
+        auto position = g_seekable_tell(_seekable);
+        g_seekable_seek(_seekable, 0, G_SEEK_END, _cancellable, &error);
+        if (error == nullptr) {
+            _size = g_seekable_tell(_seekable);
+            g_seekable_seek(_seekable, position, G_SEEK_SET, _cancellable, &error);
+        }
+
+        if (error != nullptr) {
+            g_critical("Failed to seek: %s", error->message);
+            _error = error;
+        }
 
-        auto position = tell();
-        seek(0, Exiv2::BasicIo::end);
-        _size = tell();
         g_debug("GioIo has size of %zu", _size);
-        seek(position, Exiv2::BasicIo::beg);
+        _position = _stream_position = static_cast<size_t>(position);
     }
 
     using size_type = size_t;
@@ -27,9 +53,15 @@ class GioIo : public Exiv2::BasicIo {
 
     ~GioIo() override {
         g_clear_object(&_is);
+        g_clear_object(&_cancellable);
         g_clear_error(&_error);
         _seekable = nullptr;
 
+        if (_mapped_file != nullptr) {
+            g_critical("Mismatching mmap/munmap calls, expect memory leak");
+            g_clear_pointer(&_mapped_file, g_mapped_file_unref);
+        }
+
         if (_mmap_stream != nullptr) {
             g_object_unref(G_OBJECT(_mmap_stream));
             if (_mmap_stream != nullptr) {
@@ -56,39 +88,56 @@ class GioIo : public Exiv2::BasicIo {
         Exiv2::DataBuf b{rcount};
 
         auto bytes_read = this->read(b.data(), rcount);
-        if (bytes_read > 0 && bytes_read != rcount) {
-            b = Exiv2::DataBuf{b};
+        if (bytes_read != rcount) {
+            b.resize(bytes_read);
         }
 
         return b;
     }
 
     size_type read(Exiv2::byte* buf, size_type rcount) override {
-        GError* error = NULL;
-        gssize result = 0;
-
-        result = g_input_stream_read(_is, reinterpret_cast<void*>(buf), rcount, NULL, &error);
-        if (error != NULL) {
-            g_critical("Error reading from stream: %d %s", error->code, error->message);
-            g_clear_error(&_error);
-            _error = error;
+        size_type total = 0;
 
-            throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
-            return 0;
+        // Serve whatever is available from the read-ahead buffer first
+        if (in_buffer()) {
+            total = std::min(rcount, _buffer_start + _buffer_fill - _position);
+            std::memcpy(buf, _buffer.data() + (_position - _buffer_start), total);
+            _position += total;
         }
 
-        if (result == 0) {
-            _eof = true;
-        } else {
-            _eof = false;
+        if (total < rcount) {
+            auto remaining = rcount - total;
+
+            // Large requests would only be copied twice, so read them directly into the
+            // caller's buffer. Everything else goes through the read-ahead buffer
+            if (remaining >= _buffer_size) {
+                auto result = read_from_stream(buf + total, remaining);
+                _position += result;
+                total += result;
+            } else {
+                fill_buffer();
+                auto chunk = std::min(remaining, _buffer_fill);
+                std::memcpy(buf + total, _buffer.data(), chunk);
+                _position += chunk;
+                total += chunk;
+            }
         }
 
-        return result;
+        _eof = total < rcount;
+
+        return total;
     }
 
     int getb() override {
-        Exiv2::byte b;
-        return this->read(&b, 1) == 1 ? b : EOF;
+        if (!in_buffer()) {
+            fill_buffer();
+            if (_buffer_fill == 0) {
+                _eof = true;
+                return EOF;
+            }
+        }
+
+        return _buffer[_position++ - _buffer_start];
     }
 
     void transfer(Exiv2::BasicIo& /*src*/) override {
@@ -96,36 +145,44 @@ class GioIo : public Exiv2::BasicIo {
     }
 
     int seek(seek_offset_t offset, Exiv2::BasicIo::Position position) override {
-        GSeekType t = G_SEEK_SET;
+        seek_offset_t new_position = 0;
         switch (position) {
             case Exiv2::BasicIo::cur:
-                t = G_SEEK_CUR;
+                new_position = static_cast<seek_offset_t>(_position) + offset;
                 break;
             case Exiv2::BasicIo::beg:
-                t = G_SEEK_SET;
+                new_position = offset;
                 break;
             case Exiv2::BasicIo::end:
-                t = G_SEEK_END;
+                new_position = static_cast<seek_offset_t>(_size) + offset;
                 break;
             default:
                 g_assert_not_reached();
                 break;
         }
 
-        GError* error = NULL;
-        g_seekable_seek(_seekable, offset, t, NULL, &error);
-        if (error != NULL) {
+        if (new_position < 0) {
             g_clear_error(&_error);
-            g_critical("Failed to seek: %s", error->message);
-            _error = error;
+            g_critical("Failed to seek: Invalid offset %" G_GINT64_FORMAT, static_cast<gint64>(new_position));
+            _error = g_error_new(G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid seek offset");
 
             return -1;
         }
 
+        // The stream itself is only repositioned once data outside of the buffer is needed
+        _position = static_cast<size_type>(new_position);
+        _eof = false;
+
         return 0;
     }
 
-    Exiv2::byte* mmap(bool /*writable*/) override {
+    Exiv2::byte* mmap(bool writable) override {
+        if (_mapped_file != nullptr) {
+            _mapped_count++;
+
+            return reinterpret_cast<Exiv2::byte*>(g_mapped_file_get_contents(_mapped_file));
+        }
+
         if (_mmap_stream != nullptr) {
             g_debug("mmap called previously, will just output old stream");
             g_object_ref(G_OBJECT(_mmap_stream));
@@ -133,23 +190,33 @@ class GioIo : public Exiv2::BasicIo {
             return reinterpret_cast<Exiv2::byte*>(
                 g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(_mmap_stream)));
         }
+
+        // The mapping is read-only, so only use it if the caller does not intend to write
+        if (!writable && map_file()) {
+            _mapped_count = 1;
+
+            return reinterpret_cast<Exiv2::byte*>(g_mapped_file_get_contents(_mapped_file));
+        }
+
         goffset old_position;
         g_autoptr(GError) error = nullptr;
 
         old_position = g_seekable_tell(_seekable);
-        g_seekable_seek(_seekable, 0, G_SEEK_SET, nullptr, &error);
+        g_seekable_seek(_seekable, 0, G_SEEK_SET, _cancellable, &error);
         if (error != nullptr) {
             throw Exiv2::Error(Exiv2::ErrorCode::kerCallFailed, error->message);
         }
 
         _mmap_stream = g_memory_output_stream_new_resizable();
         g_object_add_weak_pointer(G_OBJECT(_mmap_stream), reinterpret_cast<gpointer*>(&_mmap_stream));
-        g_output_stream_splice(_mmap_stream, _is, G_OUTPUT_STREAM_SPLICE_NONE, nullptr, &error);
+        auto spliced = g_output_stream_splice(_mmap_stream, _is, G_OUTPUT_STREAM_SPLICE_NONE, _cancellable, &error);
         if (error != nullptr) {
             throw Exiv2::Error(Exiv2::ErrorCode::kerCallFailed, error->message);
         }
 
-        g_seekable_seek(_seekable, old_position, G_SEEK_SET, nullptr, &error);
+        _bytes_read += static_cast<size_type>(spliced);
+
+        g_seekable_seek(_seekable, old_position, G_SEEK_SET, _cancellable, &error);
         if (error != nullptr) {
             throw Exiv2::Error(Exiv2::ErrorCode::kerCallFailed, error->message);
         }
@@ -158,11 +225,19 @@ class GioIo : public Exiv2::BasicIo {
     }
 
     int munmap() override {
+        if (_mapped_file != nullptr) {
+            if (--_mapped_count == 0) {
+                g_clear_pointer(&_mapped_file, g_mapped_file_unref);
+            }
+
+            return 0;
+        }
+
         g_object_unref(G_OBJECT(_mmap_stream));
         return 0;
     }
 
-    size_type tell() const override { return static_cast<long>(g_seekable_tell(_seekable)); }
+    size_type tell() const override { return _position; }
 
     size_t size() const override { return static_cast<size_t>(_size); }
 
@@ -172,6 +247,9 @@ class GioIo : public Exiv2::BasicIo {
 
     bool eof() const override { return _eof; }
 
+    // Number of bytes read from the underlying stream so far
+    size_type bytes_read() const { return _bytes_read; }
+
     const std::string& path() const noexcept override {
         static std::string info{"GIO Wrapper"};
         return info;
@@ -180,10 +258,164 @@ class GioIo : public Exiv2::BasicIo {
     Exiv2::BasicIo::UniquePtr temporary() const { return Exiv2::BasicIo::UniquePtr(nullptr); }
 
   private:
+    // Map the file backing the stream directly, if there is one. Returns false if the stream
+    // needs to be copied into memory instead
+    bool map_file() {
+#ifdef GEXIV2_GIO_IO_CAN_MAP
+        int fd = -1;
+
+        if (G_IS_FILE_DESCRIPTOR_BASED(_is)) {
+            fd = g_file_descriptor_based_get_fd(G_FILE_DESCRIPTOR_BASED(_is));
+        } else if (G_IS_UNIX_INPUT_STREAM(_is)) {
+            fd = g_unix_input_stream_get_fd(G_UNIX_INPUT_STREAM(_is));
+        }
+
+        if (fd < 0) {
+            return false;
+        }
+
+        g_autoptr(GError) error = nullptr;
+        auto* mapped = g_mapped_file_new_from_fd(fd, FALSE, &error);
+        if (mapped == nullptr) {
+            g_debug("Failed to map stream, falling back to copying it: %s", error->message);
+
+            return false;
+        }
+
+        // Pipes, sockets or a file that changed size underneath us cannot be used as-is
+        if (g_mapped_file_get_contents(mapped) == nullptr || g_mapped_file_get_length(mapped) != _size) {
+            g_mapped_file_unref(mapped);
+
+            return false;
+        }
+
+        _mapped_file = mapped;
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    bool in_buffer() const { return _position >= _buffer_start && _position < _buffer_start + _buffer_fill; }
+
+    // Move the underlying stream to the logical position, if necessary
+    void sync_stream_position() {
+        if (_stream_position == _position) {
+            return;
+        }
+
+        GError* error = nullptr;
+        g_seekable_seek(_seekable, static_cast<goffset>(_position), G_SEEK_SET, _cancellable, &error);
+        if (error != nullptr) {
+            g_critical("Failed to seek: %s", error->message);
+            g_clear_error(&_error);
+            _error = error;
+
+            throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+        }
+
+        _stream_position = _position;
+    }
+
+    // Read up to count bytes at the logical position, only returning less on end of stream
+    size_type read_from_stream(Exiv2::byte* buf, size_type count) {
+        sync_stream_position();
+
+        GError* error = nullptr;
+        gsize result = 0;
+
+        g_input_stream_read_all(_is, reinterpret_cast<void*>(buf), count, &result, _cancellable, &error);
+        _stream_position += result;
+        _bytes_read += result;
+        if (error != nullptr) {
+            // Cancellation is requested by the caller, so it is not worth a critical
+            if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_critical("Error reading from stream: %d %s", error->code, error->message);
+            }
+            g_clear_error(&_error);
+            _error = error;
+
+            throw Exiv2::Error(Exiv2::ErrorCode::kerFailedToReadImageData);
+        }
+
+        return result;
+    }
+
+    // Refill the read-ahead buffer starting at the logical position
+    void fill_buffer() {
+        if (_buffer.size() < _buffer_size) {
+            _buffer.resize(_buffer_size);
+        }
+
+        _buffer_start = _position;
+        _buffer_fill = 0;
+        _buffer_fill = read_from_stream(_buffer.data(), _buffer_size);
+    }
+
     GInputStream* _is{nullptr};
     GOutputStream* _mmap_stream{nullptr};
+    GMappedFile* _mapped_file{nullptr};
+    size_type _mapped_count{0};
     GSeekable* _seekable{nullptr};
+    GCancellable* _cancellable{nullptr};
     GError* _error{nullptr};
     bool _eof{false};
+
+    std::vector<Exiv2::byte> _buffer;
+    size_type _buffer_size{DEFAULT_BUFFER_SIZE};
+    // Stream offset of the first byte in _buffer and the number of valid bytes in it
+    size_type _buffer_start{0};
+    size_type _buffer_fill{0};
+    // Position as seen by Exiv2 and the actual position of the underlying stream
+    size_type _position{0};
+    size_type _stream_position{0};
+    size_type _bytes_read{0};
 }; // class GioIo
+
+// Target for saving to a GOutputStream. The original image is read from memory as with MemIo,
+// but the file Exiv2 renders on writeMetadata() is passed on to the output stream from
+// transfer() instead of replacing the original
+class GioOutputIo : public Exiv2::MemIo {
+  public:
+    GioOutputIo(const Exiv2::byte* data, size_t size, GOutputStream* os, GCancellable* cancellable = nullptr)
+      : MemIo(data, size)
+      , _os(G_OUTPUT_STREAM(g_object_ref(os)))
+      , _cancellable(cancellable != nullptr ? G_CANCELLABLE(g_object_ref(cancellable)) : nullptr) {}
+
+    ~GioOutputIo() override {
+        g_clear_object(&_os);
+        g_clear_object(&_cancellable);
+        g_clear_error(&_error);
+    }
+
+    void transfer(Exiv2::BasicIo& src) override {
+        if (src.open() != 0) {
+            throw Exiv2::Error(Exiv2::ErrorCode::kerDataSourceOpenFailed, src.path(), Exiv2::strError());
+        }
+
+        // Exiv2 renders into a MemIo, so this hands out its buffer without another copy
+        auto* data = src.mmap(false);
+        auto size = src.size();
+
+        g_clear_error(&_error);
+        g_output_stream_write_all(_os, data, size, nullptr, _cancellable, &_error);
+        src.munmap();
+        src.close();
+
+        if (_error != nullptr) {
+            throw Exiv2::Error(Exiv2::ErrorCode::kerImageWriteFailed);
+        }
+    }
+
+    int error() const override { return _error == nullptr ? MemIo::error() : 1; }
+
+    // The error of the output stream, if writing to it failed
+    const GError* stream_error() const { return _error; }
+
+  private:
+    GOutputStream* _os{nullptr};
+    GCancellable* _cancellable{nullptr};
+    GError* _error{nullptr};
+}; // class GioOutputIo
 } // Anonymous namespace
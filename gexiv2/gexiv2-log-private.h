@@ -17,6 +17,9 @@ G_BEGIN_DECLS
 
 G_GNUC_INTERNAL bool gexiv2_log_is_handler_installed(void);
 
+/* Routes the messages of Exiv2 through gexiv2, safe to call more than once */
+G_GNUC_INTERNAL void gexiv2_log_init(void);
+
 G_END_DECLS
 
 #endif /* GEXIV2_LOG_PRIVATE_H */
@@ -9,9 +9,58 @@
 
 #include "gexiv2-log-private.h"
 
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+struct CapturedMessage {
+    GExiv2LogLevel level;
+    std::string text;
+};
+
+// Messages of one thread between gexiv2_log_capture_begin() and gexiv2_log_capture_end().
+// The slots are kept after the capture ends, so their strings are reused by the next one.
+struct Capture {
+    bool active{false};
+    std::vector<CapturedMessage> ring;
+    size_t capacity{0};
+    size_t first{0};
+    size_t count{0};
+    guint dropped{0};
+
+    void push(GExiv2LogLevel level, const char* msg, size_t length) {
+        if (count == capacity) {
+            // Full, the oldest message makes room
+            first = (first + 1) % capacity;
+            count--;
+            dropped++;
+        }
+
+        auto& slot = ring[(first + count) % capacity];
+        slot.level = level;
+        slot.text.assign(msg, length);
+        count++;
+    }
+};
+
+thread_local Capture capture;
+
+// Length of @msg without trailing whitespace; Exiv2 terminates all its messages with a newline
+size_t chomped_length(const char* msg) {
+    size_t length = strlen(msg);
+    while (length > 0 && g_ascii_isspace(msg[length - 1]))
+        length--;
+
+    return length;
+}
+} // namespace
+
 G_BEGIN_DECLS
 
-static GExiv2LogHandler installed_handler = nullptr;
+// Read by every thread that logs, so it can be swapped while files are being parsed
+static std::atomic<GExiv2LogHandler> installed_handler{nullptr};
 
 static GExiv2LogLevel exiv2_level_to_gexiv2_level(Exiv2::LogMsg::Level level) {
     switch (level) {
@@ -54,8 +103,15 @@ static Exiv2::LogMsg::Level gexiv2_level_to_exiv2_level(GExiv2LogLevel level) {
 }
 
 static void log_handler_converter(int level, const char *msg) {
-    if (installed_handler != nullptr)
-        installed_handler(exiv2_level_to_gexiv2_level((Exiv2::LogMsg::Level) level), msg);
+    if (capture.active) {
+        capture.push(exiv2_level_to_gexiv2_level((Exiv2::LogMsg::Level) level), msg, strlen(msg));
+
+        return;
+    }
+
+    auto handler = installed_handler.load(std::memory_order_acquire);
+    if (handler != nullptr)
+        handler(exiv2_level_to_gexiv2_level((Exiv2::LogMsg::Level) level), msg);
     else
         Exiv2::LogMsg::defaultHandler(level, msg);
 }
@@ -64,23 +120,25 @@ static void default_log_handler(GExiv2LogLevel level, const gchar *msg) {
     Exiv2::LogMsg::defaultHandler(gexiv2_level_to_exiv2_level(level), msg);
 }
 
-static void glib_log_handler(GExiv2LogLevel level, const gchar *msg_) {
-    char *msg = g_strdup(msg_);
+static void glib_log_handler(GExiv2LogLevel level, const gchar *msg) {
+    // Print without the trailing newline instead of copying the message to chomp it
+    auto length = static_cast<int>(chomped_length(msg));
+
     switch (level) {
         case GEXIV2_LOG_LEVEL_DEBUG:
-            g_debug("%s", g_strchomp(msg));
+            g_debug("%.*s", length, msg);
         break;
         
         case GEXIV2_LOG_LEVEL_INFO:
-            g_message("%s", g_strchomp(msg));
+            g_message("%.*s", length, msg);
         break;
         
         case GEXIV2_LOG_LEVEL_WARN:
-            g_warning("%s", g_strchomp(msg));
+            g_warning("%.*s", length, msg);
         break;
         
         case GEXIV2_LOG_LEVEL_ERROR:
-            g_critical("%s", g_strchomp(msg));
+            g_critical("%.*s", length, msg);
         break;
         
         case GEXIV2_LOG_LEVEL_MUTE:
@@ -88,8 +146,6 @@ static void glib_log_handler(GExiv2LogLevel level, const gchar *msg_) {
             // do nothing
         break;
     }
-
-    g_free(msg);
 }
 
 GExiv2LogLevel gexiv2_log_get_level(void) {
@@ -101,7 +157,9 @@ void gexiv2_log_set_level(GExiv2LogLevel level) {
 }
 
 GExiv2LogHandler gexiv2_log_get_handler(void) {
-    return (installed_handler != nullptr) ? installed_handler : default_log_handler;
+    auto handler = installed_handler.load(std::memory_order_acquire);
+
+    return (handler != nullptr) ? handler : default_log_handler;
 }
 
 GExiv2LogHandler gexiv2_log_get_default_handler(void) {
@@ -111,16 +169,58 @@ GExiv2LogHandler gexiv2_log_get_default_handler(void) {
 void gexiv2_log_set_handler(GExiv2LogHandler handler) {
     g_return_if_fail(handler != nullptr);
 
-    installed_handler = handler;
-    Exiv2::LogMsg::setHandler(log_handler_converter);
+    installed_handler.store(handler, std::memory_order_release);
 }
 
 void gexiv2_log_use_glib_logging(void) {
     gexiv2_log_set_handler(glib_log_handler);
 }
 
+void gexiv2_log_init(void) {
+    static gsize initialized = 0;
+
+    // Exiv2 reads its handler without a lock, so it is set once and never changed afterwards.
+    // Handlers of our own are swapped behind the converter, which falls back to Exiv2's default
+    if (g_once_init_enter(&initialized)) {
+        Exiv2::LogMsg::setHandler(log_handler_converter);
+        g_once_init_leave(&initialized, 1);
+    }
+}
+
 bool gexiv2_log_is_handler_installed(void) {
-    return (installed_handler != nullptr);
+    return (installed_handler.load(std::memory_order_acquire) != nullptr);
+}
+
+void gexiv2_log_capture_begin(guint max_messages) {
+    g_return_if_fail(max_messages > 0);
+    g_return_if_fail(!capture.active);
+
+    if (capture.ring.size() < max_messages)
+        capture.ring.resize(max_messages);
+
+    capture.capacity = max_messages;
+    capture.first = 0;
+    capture.count = 0;
+    capture.dropped = 0;
+    capture.active = true;
+}
+
+guint gexiv2_log_capture_end(GExiv2LogHandler handler) {
+    g_return_val_if_fail(capture.active, 0);
+
+    // Messages logged by @handler itself go to the usual handler
+    capture.active = false;
+
+    if (handler == nullptr)
+        handler = gexiv2_log_get_handler();
+
+    for (size_t i = 0; i < capture.count; i++) {
+        const auto& message = capture.ring[(capture.first + i) % capture.capacity];
+        handler(message.level, message.text.c_str());
+    }
+    capture.count = 0;
+
+    return capture.dropped;
 }
 
 G_END_DECLS
@@ -95,7 +95,8 @@ GExiv2LogHandler	gexiv2_log_get_default_handler(void);
  *
  * Replace the default handler with a custom log handler.
  *
- * This method is not thread-safe.  It's best to set this before beginning to use gexiv2.
+ * The handler may be replaced while other threads are logging; each message goes either to
+ * the previous or to the new handler.  Messages can arrive on any thread that uses gexiv2.
  */
 void				gexiv2_log_set_handler(GExiv2LogHandler handler);
 
@@ -116,6 +117,39 @@ void				gexiv2_log_set_handler(GExiv2LogHandler handler);
  */
 void				gexiv2_log_use_glib_logging(void);
 
+/**
+ * gexiv2_log_capture_begin:
+ * @max_messages: The number of messages to keep
+ *
+ * Collects the log messages of the calling thread instead of passing them to the handler,
+ * until [func@GExiv2.log_capture_end] is called on the same thread.
+ *
+ * This keeps the handler out of parsing, for example when a worker reads a batch of damaged
+ * files that produce many warnings. Only the last @max_messages messages are kept. Collecting
+ * takes no locks, and once a thread has captured messages before, it usually does not allocate
+ * memory either.
+ *
+ * Captures must not be nested.
+ *
+ * Since: 0.17.0
+ */
+void				gexiv2_log_capture_begin(guint max_messages);
+
+/**
+ * gexiv2_log_capture_end:
+ * @handler: (scope call) (nullable): The [callback@GExiv2.LogHandler] to receive the collected
+ *   messages, or %NULL for the current handler
+ *
+ * Stops collecting the log messages of the calling thread and passes the collected messages to
+ * @handler, oldest first.
+ *
+ * Returns: The number of messages that were dropped because more than the maximum given to
+ *   [func@GExiv2.log_capture_begin] were logged
+ *
+ * Since: 0.17.0
+ */
+guint				gexiv2_log_capture_end(GExiv2LogHandler handler);
+
 G_END_DECLS
 
 #endif /* GEXIV2_LOG_H */
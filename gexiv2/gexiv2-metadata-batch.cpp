@@ -0,0 +1,289 @@
+/*
+ * gexiv2-metadata-batch.cpp
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-metadata-batch.h"
+#include "gexiv2-metadata-private.h"
+#include "gexiv2-metadata.h"
+#include "gexiv2-tag-id-private.h"
+#include "gexiv2-util-private.h"
+
+#include <algorithm>
+#include <exiv2/exiv2.hpp>
+#include <glib-object.h>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+struct Change {
+    std::string tag;
+    std::vector<std::string> values;
+};
+
+// A change that passed validation, with its values already converted
+struct PreparedChange {
+    std::unique_ptr<GExiv2TagId> id;
+    const Change* change = nullptr;
+    Exiv2::TypeId type = Exiv2::invalidTypeId;
+    std::vector<Exiv2::Value::UniquePtr> values;
+    bool applied = false;
+};
+
+template<typename Id>
+struct FamilyChanges {
+    std::unordered_map<Id, PreparedChange> changes;
+
+    // Changes in the order of their keys, which is the order new entries are added in
+    std::vector<PreparedChange*> sorted() {
+        std::vector<PreparedChange*> result;
+        result.reserve(changes.size());
+        for (auto& change : changes)
+            result.push_back(&change.second);
+
+        std::sort(result.begin(), result.end(),
+                  [](const PreparedChange* a, const PreparedChange* b) { return a->id->name < b->id->name; });
+
+        return result;
+    }
+};
+} // namespace
+
+struct _GExiv2MetadataBatch {
+    std::vector<Change> changes;
+};
+
+G_DEFINE_BOXED_TYPE(GExiv2MetadataBatch, gexiv2_metadata_batch, gexiv2_metadata_batch_copy, gexiv2_metadata_batch_free)
+
+GExiv2MetadataBatch* gexiv2_metadata_batch_new(void) {
+    return new GExiv2MetadataBatch();
+}
+
+GExiv2MetadataBatch* gexiv2_metadata_batch_copy(GExiv2MetadataBatch* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return new GExiv2MetadataBatch(*self);
+}
+
+void gexiv2_metadata_batch_free(GExiv2MetadataBatch* self) {
+    delete self;
+}
+
+void gexiv2_metadata_batch_set_tag_string(GExiv2MetadataBatch* self, const gchar* tag, const gchar* value) {
+    g_return_if_fail(self != nullptr);
+    g_return_if_fail(tag != nullptr);
+    g_return_if_fail(value != nullptr);
+
+    self->changes.push_back({tag, {value}});
+}
+
+void gexiv2_metadata_batch_set_tag_multiple(GExiv2MetadataBatch* self, const gchar* tag, const gchar* const* values) {
+    g_return_if_fail(self != nullptr);
+    g_return_if_fail(tag != nullptr);
+    g_return_if_fail(values != nullptr);
+
+    Change change{tag, {}};
+    for (auto value = values; *value != nullptr; value++)
+        change.values.emplace_back(*value);
+
+    self->changes.push_back(std::move(change));
+}
+
+void gexiv2_metadata_batch_clear_tag(GExiv2MetadataBatch* self, const gchar* tag) {
+    g_return_if_fail(self != nullptr);
+    g_return_if_fail(tag != nullptr);
+
+    self->changes.push_back({tag, {}});
+}
+
+// Takes the type of the first existing entry of every changed tag, which is what setting a
+// single tag keeps as well
+template<typename Container, typename Id, typename GetId>
+static void gexiv2_metadata_batch_find_types(const Container& container, FamilyChanges<Id>& family, GetId get_id) {
+    if (family.changes.empty())
+        return;
+
+    for (const auto& datum : container) {
+        auto it = family.changes.find(get_id(datum));
+        if (it != family.changes.end() && it->second.type == Exiv2::invalidTypeId)
+            it->second.type = datum.typeId();
+    }
+}
+
+// How the values of a change map to Exiv2 values
+enum class ValueMode {
+    // Only the last value is kept
+    LAST,
+    // Every value is read into the same Exiv2 value, which for arrays appends it
+    ACCUMULATE,
+    // Every value becomes a separate entry
+    EACH,
+};
+
+// Converts the values of change to its type, failing without side effects if any is invalid
+static gboolean gexiv2_metadata_batch_read_values(PreparedChange& change, ValueMode mode, GError** error) {
+    const auto& values = change.change->values;
+    if (values.empty())
+        return TRUE;
+
+    Exiv2::Value::UniquePtr value;
+    auto first = mode == ValueMode::LAST ? std::prev(values.end()) : values.begin();
+    for (auto it = first; it != values.end(); ++it) {
+        if (!value)
+            value = Exiv2::Value::create(change.type);
+
+        if (value->read(*it) != 0) {
+            g_set_error(error, g_quark_from_string("GExiv2"), 501, "Invalid value for %s: %s", change.id->name.c_str(),
+                        it->c_str());
+            return FALSE;
+        }
+
+        if (mode == ValueMode::EACH)
+            change.values.push_back(std::move(value));
+    }
+
+    if (value)
+        change.values.push_back(std::move(value));
+
+    return TRUE;
+}
+
+// Updates the first entry of every changed tag in place and removes the others, in one pass over
+// the container, then adds the values that had no entry to go to
+template<typename Key, typename Container, typename Id, typename GetId>
+static void gexiv2_metadata_batch_merge(Container& container, FamilyChanges<Id>& family, GetId get_id) {
+    if (family.changes.empty())
+        return;
+
+    auto it = container.begin();
+    while (it != container.end()) {
+        auto change = family.changes.find(get_id(*it));
+        if (change == family.changes.end()) {
+            ++it;
+            continue;
+        }
+
+        auto& prepared = change->second;
+        if (!prepared.applied && !prepared.values.empty()) {
+            it->setValue(prepared.values.front().get());
+            prepared.applied = true;
+            ++it;
+        } else {
+            it = container.erase(it);
+        }
+    }
+
+    for (auto* prepared : family.sorted()) {
+        const auto& key = static_cast<const Key&>(*prepared->id->key);
+        for (size_t i = prepared->applied ? 1 : 0; i < prepared->values.size(); i++)
+            container.add(key, prepared->values[i].get());
+    }
+}
+
+gboolean gexiv2_metadata_apply_batch(GExiv2Metadata* self, GExiv2MetadataBatch* batch, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(batch != nullptr, FALSE);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    FamilyChanges<guint32> exif;
+    FamilyChanges<std::string> xmp;
+    FamilyChanges<guint32> iptc;
+
+    auto exif_id = [](const Exiv2::Exifdatum& datum) {
+        return detail::numeric_key(static_cast<guint32>(datum.ifdId()), datum.tag());
+    };
+    auto xmp_id = [](const Exiv2::Xmpdatum& datum) { return datum.key(); };
+    auto iptc_id = [](const Exiv2::Iptcdatum& datum) { return detail::numeric_key(datum.record(), datum.tag()); };
+
+    try {
+        auto& exif_data = priv->image->exifData();
+        auto& xmp_data = priv->image->xmpData();
+        auto& iptc_data = priv->image->iptcData();
+
+        // Validate everything before changing anything. Later changes replace earlier ones of
+        // the same key.
+        for (const auto& change : batch->changes) {
+            if (!gexiv2_metadata_check_family_loaded(self, change.tag.c_str(), error))
+                return FALSE;
+
+            PreparedChange prepared;
+            prepared.id = detail::parse_tag_id(change.tag.c_str(), error);
+            if (!prepared.id)
+                return FALSE;
+
+            prepared.change = &change;
+
+            const auto& id = *prepared.id;
+            if (id.family == GEXIV2_OPEN_EXIF) {
+                const auto& key = static_cast<const Exiv2::ExifKey&>(*id.key);
+                exif.changes[detail::numeric_key(static_cast<guint32>(key.ifdId()), key.tag())] = std::move(prepared);
+            } else if (id.family == GEXIV2_OPEN_IPTC) {
+                const auto& key = static_cast<const Exiv2::IptcKey&>(*id.key);
+                iptc.changes[detail::numeric_key(key.record(), key.tag())] = std::move(prepared);
+            } else {
+                xmp.changes[id.key->key()] = std::move(prepared);
+            }
+        }
+
+        gexiv2_metadata_batch_find_types(exif_data, exif, exif_id);
+        gexiv2_metadata_batch_find_types(xmp_data, xmp, xmp_id);
+        gexiv2_metadata_batch_find_types(iptc_data, iptc, iptc_id);
+
+        // Exif tags only store one value, so the last one is used
+        for (auto& change : exif.changes) {
+            auto& prepared = change.second;
+            if (prepared.type == Exiv2::invalidTypeId)
+                prepared.type = static_cast<const Exiv2::ExifKey&>(*prepared.id->key).defaultTypeId();
+            if (!gexiv2_metadata_batch_read_values(prepared, ValueMode::LAST, error))
+                return FALSE;
+        }
+
+        // Values of XMP arrays accumulate in a single entry
+        for (auto& change : xmp.changes) {
+            auto& prepared = change.second;
+            if (prepared.type == Exiv2::invalidTypeId)
+                prepared.type = Exiv2::XmpProperties::propertyType(static_cast<const Exiv2::XmpKey&>(*prepared.id->key));
+            if (!gexiv2_metadata_batch_read_values(prepared, ValueMode::ACCUMULATE, error))
+                return FALSE;
+        }
+
+        // Repeatable IPTC tags exist as separate entries, one per value
+        for (auto& change : iptc.changes) {
+            auto& prepared = change.second;
+            const auto& key = static_cast<const Exiv2::IptcKey&>(*prepared.id->key);
+            if (prepared.type == Exiv2::invalidTypeId)
+                prepared.type = Exiv2::IptcDataSets::dataSetType(key.tag(), key.record());
+            auto mode = Exiv2::IptcDataSets::dataSetRepeatable(key.tag(), key.record()) ? ValueMode::EACH : ValueMode::LAST;
+            if (!gexiv2_metadata_batch_read_values(prepared, mode, error))
+                return FALSE;
+        }
+
+        // Everything that can fail on bad input failed above, the merge itself only allocates.
+        // The indices are dropped first, so that they never describe a container they missed
+        // changes of.
+        if (!exif.changes.empty())
+            gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+        if (!xmp.changes.empty())
+            gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
+        if (!iptc.changes.empty())
+            gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_IPTC);
+
+        gexiv2_metadata_batch_merge<Exiv2::ExifKey>(exif_data, exif, exif_id);
+        gexiv2_metadata_batch_merge<Exiv2::XmpKey>(xmp_data, xmp, xmp_id);
+        gexiv2_metadata_batch_merge<Exiv2::IptcKey>(iptc_data, iptc, iptc_id);
+
+        return TRUE;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,104 @@
+/*
+ * gexiv2-metadata-batch.h
+ *
+ * Collected tag changes, applied to a GExiv2Metadata at once
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_METADATA_BATCH_H
+#define GEXIV2_METADATA_BATCH_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GEXIV2_TYPE_METADATA_BATCH (gexiv2_metadata_batch_get_type())
+
+/**
+ * GExiv2MetadataBatch:
+ *
+ * A set of tag changes, applied with [method@GExiv2.Metadata.apply_batch].
+ *
+ * Every change replaces all values of its tag, as [method@GExiv2.Metadata.set_tag_multiple]
+ * does. If a tag is changed more than once, the last change wins.
+ *
+ * Since: 0.17.0
+ */
+typedef struct _GExiv2MetadataBatch GExiv2MetadataBatch;
+
+GType gexiv2_metadata_batch_get_type(void) G_GNUC_CONST;
+
+/**
+ * gexiv2_metadata_batch_new:
+ *
+ * Returns: (transfer full): A new, empty [struct@GExiv2.MetadataBatch]
+ *
+ * Since: 0.17.0
+ */
+GExiv2MetadataBatch* gexiv2_metadata_batch_new(void);
+
+/**
+ * gexiv2_metadata_batch_copy:
+ * @self: A [struct@GExiv2.MetadataBatch]
+ *
+ * Returns: (transfer full): A new [struct@GExiv2.MetadataBatch] with the changes of @self
+ *
+ * Since: 0.17.0
+ */
+GExiv2MetadataBatch* gexiv2_metadata_batch_copy(GExiv2MetadataBatch* self);
+
+/**
+ * gexiv2_metadata_batch_free:
+ * @self: (transfer full): A [struct@GExiv2.MetadataBatch]
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_metadata_batch_free(GExiv2MetadataBatch* self);
+
+/**
+ * gexiv2_metadata_batch_set_tag_string:
+ * @self: A [struct@GExiv2.MetadataBatch]
+ * @tag: Exiv2 tag name
+ * @value: The value to set
+ *
+ * Records that @tag is to be set to @value. Any other values of @tag are removed, including
+ * those of repeatable IPTC tags.
+ *
+ * The Exiv2 Tag Reference can be found at <http://exiv2.org/metadata.html>
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_metadata_batch_set_tag_string(GExiv2MetadataBatch* self, const gchar* tag, const gchar* value);
+
+/**
+ * gexiv2_metadata_batch_set_tag_multiple:
+ * @self: A [struct@GExiv2.MetadataBatch]
+ * @tag: Exiv2 tag name
+ * @values: (array zero-terminated=1): The values to set
+ *
+ * Records that the values of @tag are to be replaced by @values, with the same result as
+ * [method@GExiv2.Metadata.set_tag_multiple]. An empty @values removes @tag.
+ *
+ * The Exiv2 Tag Reference can be found at <http://exiv2.org/metadata.html>
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_metadata_batch_set_tag_multiple(GExiv2MetadataBatch* self, const gchar* tag, const gchar* const* values);
+
+/**
+ * gexiv2_metadata_batch_clear_tag:
+ * @self: A [struct@GExiv2.MetadataBatch]
+ * @tag: Exiv2 tag name
+ *
+ * Records that all values of @tag are to be removed.
+ *
+ * The Exiv2 Tag Reference can be found at <http://exiv2.org/metadata.html>
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_metadata_batch_clear_tag(GExiv2MetadataBatch* self, const gchar* tag);
+
+G_END_DECLS
+
+#endif /* GEXIV2_METADATA_BATCH_H */
@@ -41,13 +41,7 @@ gboolean gexiv2_metadata_has_exif_tag(GExiv2Metadata *self, const gchar* tag) {
 
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
 
-    Exiv2::ExifData& exif_data = priv->image->exifData();
-    for (Exiv2::ExifData::iterator it = exif_data.begin(); it != exif_data.end(); ++it) {
-        if (it->count() > 0 && g_ascii_strcasecmp(tag, it->key().c_str()) == 0)
-            return TRUE;
-    }
-    
-    return FALSE;
+    return priv->tag_index->contains(GEXIV2_OPEN_EXIF, priv->image->exifData(), tag);
 }
 
 gboolean gexiv2_metadata_clear_exif_tag(GExiv2Metadata *self, const gchar* tag) {
@@ -59,6 +53,10 @@ gboolean gexiv2_metadata_clear_exif_tag(GExiv2Metadata *self, const gchar* tag)
 
     Exiv2::ExifData& exif_data = priv->image->exifData();
 
+    // Spares the walk over all entries for tags that are not there
+    if (!priv->tag_index->contains(GEXIV2_OPEN_EXIF, exif_data, tag))
+        return FALSE;
+
     gboolean erased = FALSE;
 
     Exiv2::ExifData::iterator it = exif_data.begin();
@@ -70,7 +68,10 @@ gboolean gexiv2_metadata_clear_exif_tag(GExiv2Metadata *self, const gchar* tag)
             it++;
         }
     }
-    
+
+    if (erased)
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+
     return erased;
 }
 
@@ -81,6 +82,7 @@ void gexiv2_metadata_clear_exif (GExiv2Metadata *self) {
     g_return_if_fail(priv->image.get() != nullptr);
 
     priv->image->exifData().clear();
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
 }
 
 gchar** gexiv2_metadata_get_exif_tags(GExiv2Metadata* self) {
@@ -89,37 +91,25 @@ gchar** gexiv2_metadata_get_exif_tags(GExiv2Metadata* self) {
 
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
 
-    // get a copy of the ExifData and sort it by tags, preserving sort of original
-    Exiv2::ExifData exif_data = Exiv2::ExifData(priv->image->exifData());
-    exif_data.sortByKey();
-    // FIXME: Use detail::sortMetadata(exif_data);
-    // Something is not right in ExifData that makes std::sort fail
+    return detail::keys_to_strv(priv->tag_index->sorted_keys(GEXIV2_OPEN_EXIF, priv->image->exifData()));
+}
 
-    GSList* list = nullptr;
-    GSList* list_iter = nullptr;
-    gchar** data = nullptr;
-    gint count = 0;
-    
-    for (Exiv2::ExifData::iterator it = exif_data.begin(); it != exif_data.end(); ++it) {
-        if (it->count() > 0) {
-            list = g_slist_prepend (list, g_strdup (it->key ().c_str ()));
-            count++;
-        }
-    }
-    
-    data = g_new (gchar*, count + 1);
-    data[count--] = nullptr;
-    for (list_iter = list; list_iter != nullptr; list_iter = list_iter->next)
-        data[count--] = static_cast<gchar*>(list_iter->data);
+gchar* gexiv2_metadata_get_exif_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+    g_return_val_if_fail(tag != nullptr, nullptr);
 
-    g_slist_free (list);
+    try {
+        return gexiv2_metadata_get_exif_tag_string(self, Exiv2::ExifKey(tag), error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
 
-    return data;
+    return nullptr;
 }
 
-gchar* gexiv2_metadata_get_exif_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+gchar* gexiv2_metadata_get_exif_tag_string(GExiv2Metadata* self, const Exiv2::ExifKey& key, GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
-    g_return_val_if_fail(tag != nullptr, nullptr);
     auto* priv = gexiv2_priv(self);
 
     g_return_val_if_fail(priv != nullptr, nullptr);
@@ -129,7 +119,7 @@ gchar* gexiv2_metadata_get_exif_tag_string (GExiv2Metadata *self, const gchar* t
     try {
         Exiv2::ExifData& exif_data = priv->image->exifData();
 
-        Exiv2::ExifData::iterator it = exif_data.findKey(Exiv2::ExifKey(tag));
+        Exiv2::ExifData::iterator it = exif_data.findKey(key);
         while (it != exif_data.end() && it->count() == 0)
             it++;
         
@@ -197,6 +187,8 @@ gboolean gexiv2_metadata_set_exif_tag_multiple(GExiv2Metadata* self,
     try {
         Exiv2::ExifData& exif_data = priv->image->exifData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+
         auto it = exif_data.findKey(Exiv2::ExifKey(tag));
 
         if (it != exif_data.end())
@@ -261,8 +253,24 @@ gchar* gexiv2_metadata_get_exif_tag_interpreted_string (GExiv2Metadata *self, co
 }
 
 gboolean gexiv2_metadata_set_exif_tag_string (GExiv2Metadata *self, const gchar* tag, const gchar* value, GError **error) {
-    g_return_val_if_fail(GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(tag != NULL, FALSE);
+
+    try {
+        return gexiv2_metadata_set_exif_tag_string(self, Exiv2::ExifKey(tag), value, error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_set_exif_tag_string(GExiv2Metadata* self,
+                                             const Exiv2::ExifKey& key,
+                                             const gchar* value,
+                                             GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(value != NULL, FALSE);
     auto* priv = gexiv2_priv(self);
 
@@ -270,7 +278,8 @@ gboolean gexiv2_metadata_set_exif_tag_string (GExiv2Metadata *self, const gchar*
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
     
     try {
-        priv->image->exifData()[tag] = value;
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+        detail::datum_for_key<Exiv2::Exifdatum>(priv->image->exifData(), key) = value;
 
         return TRUE;
     } catch (Exiv2::Error& e) {
@@ -283,8 +292,21 @@ gboolean gexiv2_metadata_set_exif_tag_string (GExiv2Metadata *self, const gchar*
 }
 
 glong gexiv2_metadata_get_exif_tag_long (GExiv2Metadata *self, const gchar* tag, GError **error) {
-    g_return_val_if_fail(GEXIV2_IS_METADATA (self), 0);
     g_return_val_if_fail(tag != nullptr, 0);
+
+    try {
+        return gexiv2_metadata_get_exif_tag_long(self, Exiv2::ExifKey(tag), error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return 0;
+}
+
+glong gexiv2_metadata_get_exif_tag_long(GExiv2Metadata* self, const Exiv2::ExifKey& key, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA (self), 0);
     auto* priv = gexiv2_priv(self);
 
     g_return_val_if_fail(priv != nullptr, 0);
@@ -294,7 +316,7 @@ glong gexiv2_metadata_get_exif_tag_long (GExiv2Metadata *self, const gchar* tag,
     try {
         Exiv2::ExifData& exif_data = priv->image->exifData();
 
-        Exiv2::ExifData::iterator it = exif_data.findKey(Exiv2::ExifKey(tag));
+        Exiv2::ExifData::iterator it = exif_data.findKey(key);
         while (it != exif_data.end() && it->count() == 0)
             it++;
         if (it != exif_data.end())
@@ -317,6 +339,7 @@ gboolean gexiv2_metadata_set_exif_tag_long (GExiv2Metadata *self, const gchar* t
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
     
     try {
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         priv->image->exifData()[tag] = static_cast<int32_t>(value);
 
         return TRUE;
@@ -377,6 +400,7 @@ gboolean gexiv2_metadata_set_exif_tag_rational (GExiv2Metadata *self, const gcha
         Exiv2::Rational r;
         r.first = nom;
         r.second = den;
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         priv->image->exifData()[tag] = r;
 
         return TRUE;
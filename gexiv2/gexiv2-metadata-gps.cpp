@@ -332,6 +332,8 @@ gboolean gexiv2_metadata_update_gps_info (GExiv2Metadata *self, gdouble longitud
     try {
         Exiv2::ExifData& exif_data = priv->image->exifData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+
         gchar buffer [100];
         gint deg, min, sec;
         gdouble remainder, whole;
@@ -414,6 +416,8 @@ void gexiv2_metadata_delete_gps_info (GExiv2Metadata *self, GError **error) {
     try {
         Exiv2::ExifData& exif_data = priv->image->exifData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
+
         /* clear in exif data */
         Exiv2::ExifData::iterator exif_it = exif_data.begin();
         while (exif_it != exif_data.end()) {
@@ -434,6 +438,8 @@ void gexiv2_metadata_delete_gps_info (GExiv2Metadata *self, GError **error) {
     try {
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
+
         /* clear in xmp data */
         Exiv2::XmpData::iterator xmp_it = xmp_data.begin();
         while (xmp_it != xmp_data.end()) {
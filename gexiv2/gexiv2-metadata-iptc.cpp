@@ -35,14 +35,7 @@ gboolean gexiv2_metadata_has_iptc_tag(GExiv2Metadata *self, const gchar* tag) {
 
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
 
-    Exiv2::IptcData& iptc_data = priv->image->iptcData();
-
-    for (Exiv2::IptcData::iterator it = iptc_data.begin(); it != iptc_data.end(); ++it) {
-        if (it->count() > 0 && g_ascii_strcasecmp(tag, it->key().c_str()) == 0)
-            return TRUE;
-    }
-    
-    return FALSE;
+    return priv->tag_index->contains(GEXIV2_OPEN_IPTC, priv->image->iptcData(), tag);
 }
 
 gboolean gexiv2_metadata_clear_iptc_tag(GExiv2Metadata *self, const gchar* tag) {
@@ -54,6 +47,10 @@ gboolean gexiv2_metadata_clear_iptc_tag(GExiv2Metadata *self, const gchar* tag)
 
     Exiv2::IptcData& iptc_data = priv->image->iptcData();
 
+    // Spares the walk over all entries for tags that are not there
+    if (!priv->tag_index->contains(GEXIV2_OPEN_IPTC, iptc_data, tag))
+        return FALSE;
+
     gboolean erased = FALSE;
 
     Exiv2::IptcData::iterator it = iptc_data.begin();
@@ -65,7 +62,10 @@ gboolean gexiv2_metadata_clear_iptc_tag(GExiv2Metadata *self, const gchar* tag)
             it++;
         }
     }
-    
+
+    if (erased)
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_IPTC);
+
     return erased;
 }
 
@@ -76,6 +76,7 @@ void gexiv2_metadata_clear_iptc (GExiv2Metadata *self) {
     g_return_if_fail(priv->image.get() != nullptr);
 
     priv->image->iptcData().clear();
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_IPTC);
 }
 
 gchar** gexiv2_metadata_get_iptc_tags(GExiv2Metadata* self) {
@@ -85,37 +86,25 @@ gchar** gexiv2_metadata_get_iptc_tags(GExiv2Metadata* self) {
     g_return_val_if_fail(priv != nullptr, nullptr);
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
 
-    // get a copy of the IptcData and sort it by key, preserving the original
-    Exiv2::IptcData iptc_data = Exiv2::IptcData(priv->image->iptcData());
-    detail::sortMetadata(iptc_data);
+    return detail::keys_to_strv(priv->tag_index->sorted_keys(GEXIV2_OPEN_IPTC, priv->image->iptcData()));
+}
 
-    GSList* list = nullptr;
-    GSList* list_iter = nullptr;
-    gchar** data = nullptr;
-    gint count = 0;
-    gchar* previous_tag = nullptr; // From previous iteration
+gchar* gexiv2_metadata_get_iptc_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+    g_return_val_if_fail(tag != nullptr, nullptr);
 
-    for (const auto& it : iptc_data) {
-        if (it.count() > 0 && (previous_tag == nullptr || it.key() != previous_tag)) {
-            list = g_slist_prepend(list, g_strdup(it.key().c_str()));
-            count++;
-            previous_tag = static_cast<gchar*>(list->data);
-        }
+    try {
+        return gexiv2_metadata_get_iptc_tag_string(self, Exiv2::IptcKey(tag), error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
     }
 
-    data = g_new(gchar*, count + 1);
-    data[count--] = nullptr;
-    for (list_iter = list; list_iter != nullptr; list_iter = list_iter->next)
-        data[count--] = static_cast<gchar*>(list_iter->data);
-
-    g_slist_free(list);
-
-    return data;
+    return nullptr;
 }
 
-gchar* gexiv2_metadata_get_iptc_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+gchar* gexiv2_metadata_get_iptc_tag_string(GExiv2Metadata* self, const Exiv2::IptcKey& key, GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA (self), nullptr);
-    g_return_val_if_fail(tag != nullptr, nullptr);
     auto* priv = gexiv2_priv(self);
 
     g_return_val_if_fail(priv != nullptr, nullptr);
@@ -124,7 +113,6 @@ gchar* gexiv2_metadata_get_iptc_tag_string (GExiv2Metadata *self, const gchar* t
 
     try {
         const auto& iptc_data = priv->image->iptcData();
-        const Exiv2::IptcKey key(tag);
         auto it = iptc_data.findKey(key);
 
         while (it != iptc_data.end() && it->count() == 0)
@@ -143,7 +131,7 @@ gchar* gexiv2_metadata_get_iptc_tag_string (GExiv2Metadata *self, const gchar* t
             gboolean add_separator = FALSE;
 
             for (; it != iptc_data.end(); ++it) {
-                if (it->key() == tag) {
+                if (it->key() == key.key()) {
                     if (add_separator == TRUE) {
                     	os << SEPARATOR;
                     }
@@ -214,8 +202,24 @@ gchar* gexiv2_metadata_get_iptc_tag_interpreted_string (GExiv2Metadata *self, co
 
 gboolean gexiv2_metadata_set_iptc_tag_string (GExiv2Metadata *self, const gchar* tag,
     const gchar* value, GError **error) {
-    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(tag != nullptr, FALSE);
+
+    try {
+        return gexiv2_metadata_set_iptc_tag_string(self, Exiv2::IptcKey(tag), value, error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_set_iptc_tag_string(GExiv2Metadata* self,
+                                             const Exiv2::IptcKey& key,
+                                             const gchar* value,
+                                             GError** error) {
+    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(value != nullptr, FALSE);
     auto* priv = gexiv2_priv(self);
 
@@ -224,30 +228,20 @@ gboolean gexiv2_metadata_set_iptc_tag_string (GExiv2Metadata *self, const gchar*
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
     
     try {
-        const Exiv2::IptcKey key(tag);
         auto& iptc_data = priv->image->iptcData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_IPTC);
+
         // Iptc allows Repeatable tags (multi-value) and Non-Repeatable tags
     	// (single value). Repeatable tags are not grouped together, but exist as
     	// separate entries with the same tag name.
         if (!Exiv2::IptcDataSets::dataSetRepeatable(key.tag(), key.record())) {
-            iptc_data[tag] = value;
+            detail::datum_for_key<Exiv2::Iptcdatum>(iptc_data, key) = value;
             return TRUE;
         }
 
         // Repeatable values can be any type
-        GError* internal_error = nullptr;
-        const gchar* type = gexiv2_metadata_get_iptc_tag_type(tag, &internal_error);
-        if (internal_error != nullptr) {
-            g_propagate_error(error, internal_error);
-            return FALSE;
-        }
-
-        // FIXME: Can type ever be nullptr without internal_error being non-null?
-        if (type == nullptr)
-            throw Exiv2::Error(Exiv2::ErrorCode::kerInvalidKey, tag);
-
-        auto v = Exiv2::Value::create(Exiv2::TypeInfo::typeId(static_cast<const std::string>(type)));
+        auto v = Exiv2::Value::create(Exiv2::IptcDataSets::dataSetType(key.tag(), key.record()));
 
         if (v->read(static_cast<const std::string>(value)) != 0 || iptc_data.add(key,v.get()) != 0)
          	return FALSE;
@@ -322,6 +316,8 @@ gboolean gexiv2_metadata_set_iptc_tag_multiple (GExiv2Metadata *self, const gcha
     try {
         auto& iptc_data = priv->image->iptcData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_IPTC);
+
         // Iptc allows Repeatable tags (multi-value) and Non-Repeatable tags
     	// (single value). Repeatable tags are not grouped together, but exist as
     	// separate entries with the same tag name.
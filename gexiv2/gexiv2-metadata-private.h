@@ -10,22 +10,222 @@
 #ifndef GEXIV2_METADATA_PRIVATE_H
 #define GEXIV2_METADATA_PRIVATE_H
 
+#include "gexiv2-collate-private.h"
+
 #include <algorithm>
+#include <array>
 #include <exiv2/exiv2.hpp>
 #include <gexiv2/gexiv2-metadata.h>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Internal C++ functions, outside of G_BEGIN_DECLS
 // FIXME: Do we really need G_BEGIN_DECLS/END_DECLS for internal header?
 
 namespace detail {
-G_GNUC_INTERNAL std::string collate_key(const std::string& string);
+// Read only the metadata carrying parts of a JPEG, PNG, WebP or TIFF file from a seekable
+// stream. For TIFF, the result has the size of the file and holds only the IFDs and their
+// values, everything else reads as zeros, in which case sparse is set. TIFF is not handled if
+// GEXIV2_OPEN_PREVIEWS is part of families, if its structure cannot be followed, or on systems
+// without anonymous memory mappings. Returns nullptr without setting error if the
+// format is not handled; the stream is then back at its initial position. Segments holding
+// metadata of families not in families are left out.
+G_GNUC_INTERNAL Exiv2::BasicIo::UniquePtr read_metadata_segments(GInputStream* stream,
+                                                                 GCancellable* cancellable,
+                                                                 GExiv2OpenFlags families,
+                                                                 guint64& bytes_read,
+                                                                 bool& sparse,
+                                                                 GError** error);
+
+// Locates the XMP packet of a JPEG or TIFF file in a seekable stream by reading only the JPEG
+// segment headers or the first IFD. offset is relative to the initial position of the stream.
+// Returns false without setting error if the file has no packet stored in one piece there.
+G_GNUC_INTERNAL bool find_xmp_packet(GInputStream* stream,
+                                     GCancellable* cancellable,
+                                     goffset& offset,
+                                     gsize& length,
+                                     GError** error);
+
+// Numeric identity of an EXIF or IPTC key, cheaper to get from an entry than its name. group is
+// the IFD of EXIF keys and the record of IPTC keys.
+G_GNUC_INTERNAL inline guint32 numeric_key(guint32 group, guint16 tag) {
+    return (group << 16) | tag;
+}
+
+// Same as container[key.key()], without parsing the key again
+template<typename Datum, typename Container, typename Key>
+G_GNUC_INTERNAL Datum& datum_for_key(Container& container, const Key& key) {
+    auto it = container.findKey(key);
+    if (it != container.end())
+        return *it;
 
-template<typename T>
-G_GNUC_INTERNAL void sortMetadata(T& container) {
-    std::sort(container.begin(), container.end(), [](Exiv2::Metadatum& a, Exiv2::Metadatum& b) {
-        return collate_key(a.key()) < collate_key(b.key());
-    });
+    // All metadata containers append new entries
+    container.add(Datum(key));
+    return *std::prev(container.end());
 }
+
+// Order in which the get_*_tags functions list keys, as indices into keys. Exif keys are sorted
+// like ExifData::sortByKey(), XMP and IPTC keys in natural order.
+G_GNUC_INTERNAL inline std::vector<size_t> sort_order(GExiv2OpenFlags family, const std::vector<std::string>& keys) {
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if (family == GEXIV2_OPEN_EXIF) {
+        std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+        return order;
+    }
+
+    // Collate every key once into a shared buffer and sort indices, instead of collating in the
+    // comparator
+    std::string buffer;
+    std::vector<std::pair<size_t, size_t>> spans;
+    spans.reserve(keys.size());
+    for (const auto& key : keys) {
+        auto start = buffer.size();
+        collate_key(key, buffer);
+        spans.emplace_back(start, buffer.size() - start);
+    }
+
+    auto collated = [&buffer, &spans](size_t i) {
+        return std::string_view(buffer).substr(spans[i].first, spans[i].second);
+    };
+
+    std::stable_sort(order.begin(), order.end(), [&collated](size_t a, size_t b) { return collated(a) < collated(b); });
+
+    return order;
+}
+
+// Case-insensitive set of the keys that carry a value, and the sorted list of these keys, one
+// per metadata family. Both are built on the first use after the family was invalidated.
+class TagIndex {
+public:
+    template<typename T>
+    bool contains(GExiv2OpenFlags family, const T& container, const gchar* tag) {
+        auto& entry = entries[slot(family)];
+        if (!entry.valid) {
+            entry.keys.clear();
+            entry.keys.reserve(container.count());
+            for (const auto& datum : container) {
+                if (datum.count() > 0)
+                    entry.keys.insert(fold(datum.key()));
+            }
+            entry.valid = true;
+        }
+
+        return entry.keys.find(fold(tag)) != entry.keys.end();
+    }
+
+    // Keys that carry a value, in the order the get_*_tags functions return them. Repeated IPTC
+    // keys are listed once.
+    template<typename T>
+    const std::vector<std::string>& sorted_keys(GExiv2OpenFlags family, const T& container) {
+        auto& entry = entries[slot(family)];
+        if (entry.sorted_valid)
+            return entry.sorted;
+
+        auto& keys = scratch;
+        keys.clear();
+        keys.reserve(container.count());
+        for (const auto& datum : container) {
+            if (datum.count() > 0)
+                keys.push_back(datum.key());
+        }
+
+        entry.sorted.clear();
+        entry.sorted.reserve(keys.size());
+
+        for (auto i : sort_order(family, keys)) {
+            if (family == GEXIV2_OPEN_IPTC && !entry.sorted.empty() && entry.sorted.back() == keys[i])
+                continue;
+            entry.sorted.push_back(std::move(keys[i]));
+        }
+
+        entry.sorted_valid = true;
+
+        return entry.sorted;
+    }
+
+    // Changes on every invalidation, so users of container iterators can tell that these may
+    // have become invalid
+    guint64 generation() const {
+        return current_generation;
+    }
+
+    void invalidate(GExiv2OpenFlags families) {
+        current_generation++;
+        for (guint i = 0; i < entries.size(); i++) {
+            if (families & (1 << i)) {
+                entries[i].valid = false;
+                entries[i].sorted_valid = false;
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        std::unordered_set<std::string> keys;
+        bool valid = false;
+        std::vector<std::string> sorted;
+        bool sorted_valid = false;
+    };
+
+    static guint slot(GExiv2OpenFlags family) {
+        switch (family) {
+            case GEXIV2_OPEN_XMP:
+                return 1;
+            case GEXIV2_OPEN_IPTC:
+                return 2;
+            default:
+                return 0;
+        }
+    }
+
+    static std::string fold(std::string key) {
+        for (auto& c : key)
+            c = g_ascii_tolower(c);
+        return key;
+    }
+
+    // Indexed by the bit position of the family in GExiv2OpenFlags
+    std::array<Entry, 3> entries;
+    guint64 current_generation = 0;
+    // Keeps its capacity between calls of sorted_keys(), also across files
+    std::vector<std::string> scratch;
+};
+
+// Copies keys into a newly allocated, NULL terminated array
+G_GNUC_INTERNAL inline gchar** keys_to_strv(const std::vector<std::string>& keys) {
+    auto* data = g_new(gchar*, keys.size() + 1);
+    for (size_t i = 0; i < keys.size(); i++)
+        data[i] = g_strdup(keys[i].c_str());
+    data[keys.size()] = nullptr;
+
+    return data;
+}
+
+// The names asked for by gexiv2_metadata_get_tags_batch(), grouped by the key they resolve to.
+// Parsing the names is the costly part, so readers going through many files do it only once.
+struct TagRequest {
+    std::vector<std::string> names;
+    // Indices into names of those resolving to the same key
+    std::vector<std::vector<size_t>> groups;
+    // Index into groups, by key
+    std::unordered_map<guint32, size_t> exif;
+    std::unordered_map<guint32, size_t> iptc;
+    std::unordered_map<std::string, size_t> xmp;
+};
+
+// Sets error and returns false if one of tags is not a valid tag name
+G_GNUC_INTERNAL bool resolve_tags(const gchar* const* tags, TagRequest& request, GError** error);
+
+// gexiv2_metadata_get_tags_batch() with the names already resolved
+G_GNUC_INTERNAL GHashTable* get_tags_batch(GExiv2Metadata* self, const TagRequest& request, GError** error);
 }; // namespace detail
 
 G_BEGIN_DECLS
@@ -33,8 +233,13 @@ G_BEGIN_DECLS
 struct _GExiv2MetadataPrivate
 {
     Exiv2::Image::UniquePtr image;
+    /* Either %NULL or comment_buffer */
     gchar* comment;
-    gchar* mime_type;
+    /* Kept across files and only grown, see gexiv2_metadata_reset() */
+    gchar* comment_buffer;
+    gsize comment_capacity;
+    /* Interned */
+    const gchar* mime_type;
     gint pixel_width;
     gint pixel_height;
     gboolean supports_exif;
@@ -42,11 +247,32 @@ struct _GExiv2MetadataPrivate
     gboolean supports_iptc;
     Exiv2::PreviewManager *preview_manager;
     GExiv2PreviewProperties **preview_properties;
+    /* The image only holds the metadata segments of the file it was read from */
+    gboolean metadata_only;
+    /* Previews may point to data that was not read */
+    gboolean skip_previews;
+    /* preview_manager and preview_properties are set up on first use */
+    gboolean previews_loaded;
+    /* Parts of the metadata that were read from the file */
+    GExiv2OpenFlags loaded_families;
+    /* Lookup table for has_tag and clear_tag, see gexiv2_metadata_tags_changed() */
+    detail::TagIndex* tag_index;
+    /* Families changed since they were read or last saved to path */
+    GExiv2OpenFlags dirty_families;
+    /* The file the metadata was read from, if it was opened by path */
+    gchar* path;
 };
 using GExiv2MetadataPrivate = struct _GExiv2MetadataPrivate;
 
 G_GNUC_INTERNAL GExiv2MetadataPrivate* gexiv2_priv(GExiv2Metadata* self);
 
+/* Sets @error if @tag belongs to a family that was not loaded on open */
+G_GNUC_INTERNAL gboolean gexiv2_metadata_check_family_loaded(GExiv2Metadata* self, const gchar* tag, GError** error);
+
+/* Must be called whenever tags of @families or, with GEXIV2_OPEN_COMMENT, the comment were
+ * added, removed or changed. Marks @families as needing to be saved. */
+G_GNUC_INTERNAL void gexiv2_metadata_tags_changed(GExiv2MetadataPrivate* priv, GExiv2OpenFlags families);
+
 /* private EXIF functions */
 
 G_GNUC_INTERNAL gboolean		gexiv2_metadata_has_exif_tag		(GExiv2Metadata *self, const gchar* tag);
@@ -112,4 +338,36 @@ G_GNUC_INTERNAL GBytes*			gexiv2_metadata_get_iptc_tag_raw	(GExiv2Metadata *self
 
 G_END_DECLS
 
+/* Variants of the tag accessors taking an already parsed key, see GExiv2TagId */
+
+G_GNUC_INTERNAL gchar* gexiv2_metadata_get_exif_tag_string(GExiv2Metadata* self,
+                                                           const Exiv2::ExifKey& key,
+                                                           GError** error);
+G_GNUC_INTERNAL gboolean gexiv2_metadata_set_exif_tag_string(GExiv2Metadata* self,
+                                                             const Exiv2::ExifKey& key,
+                                                             const gchar* value,
+                                                             GError** error);
+G_GNUC_INTERNAL glong gexiv2_metadata_get_exif_tag_long(GExiv2Metadata* self,
+                                                        const Exiv2::ExifKey& key,
+                                                        GError** error);
+
+G_GNUC_INTERNAL gchar* gexiv2_metadata_get_xmp_tag_string(GExiv2Metadata* self,
+                                                          const Exiv2::XmpKey& key,
+                                                          GError** error);
+G_GNUC_INTERNAL gboolean gexiv2_metadata_set_xmp_tag_string(GExiv2Metadata* self,
+                                                            const Exiv2::XmpKey& key,
+                                                            const gchar* value,
+                                                            GError** error);
+G_GNUC_INTERNAL glong gexiv2_metadata_get_xmp_tag_long(GExiv2Metadata* self,
+                                                       const Exiv2::XmpKey& key,
+                                                       GError** error);
+
+G_GNUC_INTERNAL gchar* gexiv2_metadata_get_iptc_tag_string(GExiv2Metadata* self,
+                                                           const Exiv2::IptcKey& key,
+                                                           GError** error);
+G_GNUC_INTERNAL gboolean gexiv2_metadata_set_iptc_tag_string(GExiv2Metadata* self,
+                                                             const Exiv2::IptcKey& key,
+                                                             const gchar* value,
+                                                             GError** error);
+
 #endif /* GEXIV2_METADATA_PRIVATE_H */
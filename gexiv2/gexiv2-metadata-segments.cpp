@@ -0,0 +1,953 @@
+/*
+ * gexiv2-metadata-segments.cpp
+ *
+ * Reading of only the metadata carrying parts of an image file
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-metadata-private.h"
+
+#include <array>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <exiv2/exiv2.hpp>
+#include <gio/gio.h>
+
+#ifdef G_OS_UNIX
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr std::array<Exiv2::byte, 8> PNG_SIGNATURE{0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+constexpr std::array<Exiv2::byte, 12> PNG_IEND{0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xae, 0x42, 0x60, 0x82};
+
+constexpr Exiv2::byte JPEG_SOS = 0xda;
+constexpr Exiv2::byte JPEG_EOI = 0xd9;
+
+// Upper limit for the number of IFDs followed in a TIFF file, to stop on malicious offset loops
+constexpr guint MAX_TIFF_IFDS = 256;
+
+// Wraps the stream and keeps track of the number of bytes actually read from it
+class SegmentReader {
+  public:
+    SegmentReader(GInputStream* stream, GCancellable* cancellable, goffset base)
+      : _stream(stream)
+      , _cancellable(cancellable)
+      , _base(base) {}
+
+    bool read(Exiv2::byte* buffer, gsize count, GError** error) {
+        gsize result = 0;
+        auto success = g_input_stream_read_all(_stream, buffer, count, &result, _cancellable, error);
+        _bytes_read += result;
+
+        if (success && result != count) {
+            g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT, "Unexpected end of file");
+
+            return false;
+        }
+
+        return success;
+    }
+
+    bool append(std::vector<Exiv2::byte>& out, gsize count, GError** error) {
+        auto offset = out.size();
+        out.resize(offset + count);
+
+        return read(out.data() + offset, count, error);
+    }
+
+    bool skip(goffset count, GError** error) {
+        return g_seekable_seek(G_SEEKABLE(_stream), count, G_SEEK_CUR, _cancellable, error);
+    }
+
+    // Offsets are relative to the position the stream was at when the reader was created
+    bool seek(goffset offset, GError** error) {
+        return g_seekable_seek(G_SEEKABLE(_stream), _base + offset, G_SEEK_SET, _cancellable, error);
+    }
+
+    // Position relative to the one the stream was at when the reader was created
+    goffset tell() const { return g_seekable_tell(G_SEEKABLE(_stream)) - _base; }
+
+    guint64 bytes_read() const { return _bytes_read; }
+
+  private:
+    GInputStream* _stream;
+    GCancellable* _cancellable;
+    goffset _base;
+    guint64 _bytes_read{0};
+};
+
+#ifdef G_OS_UNIX
+// Stands in for a file of which only some ranges were read, the holes in between read as zeros.
+// Exiv2 decodes TIFF from mmap(), which is served from an anonymous mapping where only the
+// pages the ranges are copied into take up memory. Without such mappings the whole file would
+// have to be allocated, so TIFF is read in full there.
+class RangeIo : public Exiv2::BasicIo {
+  public:
+    explicit RangeIo(size_t size)
+      : _size(size) {}
+
+    ~RangeIo() override {
+        if (_mapping != nullptr)
+            ::munmap(_mapping, _size);
+    }
+
+    // Storage for length bytes of the file at offset, to be filled in by the caller. Ranges that
+    // overlap or touch it are merged with it, which moves their storage, so pointers returned
+    // before are no longer valid. Returns nullptr if the ranges would hold more than the file,
+    // which only happens for ranges reaching past its end.
+    Exiv2::byte* add(size_t offset, size_t length) {
+        auto end = offset + length;
+
+        // The first range that reaches offset
+        auto first = _ranges.upper_bound(offset);
+        if (first != _ranges.begin()) {
+            auto previous = std::prev(first);
+            if (previous->first + previous->second.size() >= offset)
+                first = previous;
+        }
+
+        if (first != _ranges.end() && first->first <= offset && first->first + first->second.size() >= end)
+            return first->second.data() + (offset - first->first);
+
+        auto start = offset;
+        auto stop = end;
+        size_t merged = 0;
+        auto last = first;
+        for (; last != _ranges.end() && last->first <= end; ++last) {
+            start = std::min(start, last->first);
+            stop = std::max(stop, last->first + last->second.size());
+            merged += last->second.size();
+        }
+
+        if (_held - merged + (stop - start) > _size)
+            return nullptr;
+
+        std::vector<Exiv2::byte> data(stop - start);
+        for (auto it = first; it != last; ++it)
+            memcpy(data.data() + (it->first - start), it->second.data(), it->second.size());
+
+        _ranges.erase(first, last);
+        _held = _held - merged + data.size();
+
+        return _ranges.emplace(start, std::move(data)).first->second.data() + (offset - start);
+    }
+
+    // Let length bytes at offset read as zeros, regardless of the ranges covering them
+    void clear(size_t offset, size_t length) { _cleared.emplace_back(offset, length); }
+
+    void populateFakeData() override {}
+
+    int open() override {
+        _position = 0;
+        _eof = false;
+
+        return 0;
+    }
+
+    int close() override { return 0; }
+
+    // Writing is not supported
+    size_t write(const Exiv2::byte* /*data*/, size_t /*wcount*/) override { return 0; }
+    size_t write(BasicIo& /*src*/) override { return 0; }
+    int putb(Exiv2::byte /*data*/) override { return EOF; }
+    void transfer(Exiv2::BasicIo& /*src*/) override {}
+
+    Exiv2::DataBuf read(size_t rcount) override {
+        Exiv2::DataBuf b{rcount};
+
+        auto bytes_read = this->read(b.data(), rcount);
+        if (bytes_read != rcount)
+            b.resize(bytes_read);
+
+        return b;
+    }
+
+    size_t read(Exiv2::byte* buf, size_t rcount) override {
+        auto count = _position < _size ? std::min(rcount, _size - _position) : 0;
+
+        memset(buf, 0, count);
+        overlay(buf, _position, count);
+        _position += count;
+        _eof = count < rcount;
+
+        return count;
+    }
+
+    int getb() override {
+        Exiv2::byte b = 0;
+
+        if (read(&b, 1) != 1)
+            return EOF;
+
+        return b;
+    }
+
+    int seek(int64_t offset, Exiv2::BasicIo::Position position) override {
+        int64_t new_position = offset;
+        if (position == Exiv2::BasicIo::cur)
+            new_position += static_cast<int64_t>(_position);
+        else if (position == Exiv2::BasicIo::end)
+            new_position += static_cast<int64_t>(_size);
+
+        if (new_position < 0)
+            return 1;
+
+        if (static_cast<uint64_t>(new_position) > _size) {
+            _eof = true;
+
+            return 1;
+        }
+
+        _position = static_cast<size_t>(new_position);
+        _eof = false;
+
+        return 0;
+    }
+
+    Exiv2::byte* mmap(bool /*writable*/) override {
+        if (_mapping != nullptr || _size == 0)
+            return _mapping;
+
+        auto* mapping =
+            ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (mapping == MAP_FAILED)
+            throw Exiv2::Error(Exiv2::ErrorCode::kerMallocFailed);
+        _mapping = static_cast<Exiv2::byte*>(mapping);
+
+        overlay(_mapping, 0, _size);
+
+        return _mapping;
+    }
+
+    // The mapping stays around until the io is gone, Exiv2 holds on to pointers into it
+    int munmap() override { return 0; }
+
+    size_t tell() const override { return _position; }
+
+    size_t size() const override { return _size; }
+
+    bool isopen() const override { return true; }
+
+    int error() const override { return 0; }
+
+    bool eof() const override { return _eof; }
+
+    const std::string& path() const noexcept override {
+        static std::string info{"GExiv2 metadata ranges"};
+        return info;
+    }
+
+  private:
+    // Copy the parts of the ranges that fall into [offset, offset + length) to dest
+    void overlay(Exiv2::byte* dest, size_t offset, size_t length) const {
+        auto end = offset + length;
+
+        for (const auto& [start, data] : _ranges) {
+            if (start >= end)
+                break;
+
+            auto from = std::max(start, offset);
+            auto to = std::min(start + data.size(), end);
+            if (from < to)
+                memcpy(dest + (from - offset), data.data() + (from - start), to - from);
+        }
+
+        for (const auto& [start, count] : _cleared) {
+            auto from = std::max(start, offset);
+            auto to = std::min(start + count, end);
+            if (from < to)
+                memset(dest + (from - offset), 0, to - from);
+        }
+    }
+
+    size_t _size;
+    size_t _held{0};
+    size_t _position{0};
+    bool _eof{false};
+    // Never overlapping, by offset
+    std::map<size_t, std::vector<Exiv2::byte>> _ranges;
+    std::vector<std::pair<size_t, size_t>> _cleared;
+    Exiv2::byte* _mapping{nullptr};
+};
+#endif
+
+guint16 get_uint16(const Exiv2::byte* p, bool little_endian) {
+    return little_endian ? static_cast<guint16>(p[0] | p[1] << 8) : static_cast<guint16>(p[0] << 8 | p[1]);
+}
+
+guint32 get_uint32(const Exiv2::byte* p, bool little_endian) {
+    if (little_endian) {
+        return static_cast<guint32>(p[0]) | static_cast<guint32>(p[1]) << 8 | static_cast<guint32>(p[2]) << 16 |
+               static_cast<guint32>(p[3]) << 24;
+    }
+
+    return static_cast<guint32>(p[0]) << 24 | static_cast<guint32>(p[1]) << 16 | static_cast<guint32>(p[2]) << 8 |
+           static_cast<guint32>(p[3]);
+}
+
+bool has_prefix(const Exiv2::byte* data, gsize length, const char* prefix, gsize prefix_length) {
+    return length >= prefix_length && memcmp(data, prefix, prefix_length) == 0;
+}
+
+// Long enough for the longest identifier checked below
+constexpr gsize JPEG_IDENTIFIER_LENGTH = 35;
+
+// The metadata family a JPEG segment belongs to, or GEXIV2_OPEN_ALL if it is needed regardless
+GExiv2OpenFlags jpeg_segment_family(Exiv2::byte marker, const Exiv2::byte* identifier, gsize length) {
+    switch (marker) {
+        case 0xe1: // APP1
+            if (has_prefix(identifier, length, "Exif\0\0", 6))
+                return GEXIV2_OPEN_EXIF;
+            if (has_prefix(identifier, length, "http://ns.adobe.com/xap/1.0/\0", 29) ||
+                has_prefix(identifier, length, "http://ns.adobe.com/xmp/extension/\0", 35))
+                return GEXIV2_OPEN_XMP;
+            break;
+        case 0xed: // APP13
+            if (has_prefix(identifier, length, "Photoshop 3.0\0", 14))
+                return GEXIV2_OPEN_IPTC;
+            break;
+        case 0xfe: // COM
+            return GEXIV2_OPEN_COMMENT;
+        default:
+            break;
+    }
+
+    return GEXIV2_OPEN_ALL;
+}
+
+// Copy all segments up to the start of the scan and terminate the result with EOI
+bool read_jpeg(SegmentReader& reader, std::vector<Exiv2::byte>& out, GExiv2OpenFlags families, GError** error) {
+    if (!reader.append(out, 2, error))
+        return false;
+
+    while (true) {
+        std::array<Exiv2::byte, 2> marker{};
+        if (!reader.read(marker.data(), marker.size(), error))
+            return false;
+
+        if (marker[0] != 0xff) {
+            g_set_error_literal(error, g_quark_from_string("GExiv2"), 501, "Invalid JPEG marker");
+
+            return false;
+        }
+
+        // Skip fill bytes
+        while (marker[1] == 0xff) {
+            if (!reader.read(&marker[1], 1, error))
+                return false;
+        }
+
+        if (marker[1] == JPEG_SOS || marker[1] == JPEG_EOI)
+            break;
+
+        out.push_back(marker[0]);
+        out.push_back(marker[1]);
+
+        // Markers without a payload
+        if (marker[1] == 0x01 || (marker[1] >= 0xd0 && marker[1] <= 0xd7))
+            continue;
+
+        auto length_offset = out.size();
+        if (!reader.append(out, 2, error))
+            return false;
+
+        auto length = get_uint16(out.data() + length_offset, false);
+        if (length < 2) {
+            g_set_error_literal(error, g_quark_from_string("GExiv2"), 501, "Invalid JPEG segment length");
+
+            return false;
+        }
+
+        // Look at the identifier of the segment to decide whether it is needed at all
+        auto payload_offset = out.size();
+        auto identifier_length = std::min<gsize>(length - 2, JPEG_IDENTIFIER_LENGTH);
+        if (!reader.append(out, identifier_length, error))
+            return false;
+
+        if ((jpeg_segment_family(marker[1], out.data() + payload_offset, identifier_length) & families) == 0) {
+            out.resize(payload_offset - 4);
+            if (!reader.skip(length - 2 - identifier_length, error))
+                return false;
+
+            continue;
+        }
+
+        if (!reader.append(out, length - 2 - identifier_length, error))
+            return false;
+    }
+
+    out.push_back(0xff);
+    out.push_back(JPEG_EOI);
+
+    return true;
+}
+
+// Keywords are at most 79 characters and NUL terminated
+constexpr gsize PNG_KEYWORD_LENGTH = 80;
+
+// The metadata family a PNG chunk belongs to, or GEXIV2_OPEN_ALL if it is needed regardless
+GExiv2OpenFlags png_chunk_family(const Exiv2::byte* type, const Exiv2::byte* data, gsize length) {
+    if (memcmp(type, "eXIf", 4) == 0)
+        return GEXIV2_OPEN_EXIF;
+
+    if (memcmp(type, "tEXt", 4) != 0 && memcmp(type, "zTXt", 4) != 0 && memcmp(type, "iTXt", 4) != 0)
+        return GEXIV2_OPEN_ALL;
+
+    if (has_prefix(data, length, "XML:com.adobe.xmp\0", 18) || has_prefix(data, length, "Raw profile type xmp\0", 21))
+        return GEXIV2_OPEN_XMP;
+    if (has_prefix(data, length, "Raw profile type exif\0", 22) ||
+        has_prefix(data, length, "Raw profile type APP1\0", 22))
+        return GEXIV2_OPEN_EXIF;
+    if (has_prefix(data, length, "Raw profile type iptc\0", 22))
+        return GEXIV2_OPEN_IPTC;
+    if (has_prefix(data, length, "Description\0", 12))
+        return GEXIV2_OPEN_COMMENT;
+
+    return GEXIV2_OPEN_ALL;
+}
+
+// Copy all chunks in front of the image data and terminate the result with IEND
+bool read_png(SegmentReader& reader, std::vector<Exiv2::byte>& out, GExiv2OpenFlags families, GError** error) {
+    if (!reader.append(out, PNG_SIGNATURE.size(), error))
+        return false;
+
+    while (true) {
+        std::array<Exiv2::byte, 8> header{};
+        if (!reader.read(header.data(), header.size(), error))
+            return false;
+
+        if (memcmp(header.data() + 4, "IDAT", 4) == 0 || memcmp(header.data() + 4, "IEND", 4) == 0)
+            break;
+
+        auto length = get_uint32(header.data(), false);
+        if (length > G_MAXINT32) {
+            g_set_error_literal(error, g_quark_from_string("GExiv2"), 501, "Invalid PNG chunk length");
+
+            return false;
+        }
+
+        auto chunk_offset = out.size();
+        out.insert(out.end(), header.begin(), header.end());
+
+        // Look at the keyword of text chunks to decide whether the chunk is needed at all
+        auto keyword_length = std::min<gsize>(length, PNG_KEYWORD_LENGTH);
+        if (!reader.append(out, keyword_length, error))
+            return false;
+
+        if ((png_chunk_family(header.data() + 4, out.data() + chunk_offset + 8, keyword_length) & families) == 0) {
+            out.resize(chunk_offset);
+            if (!reader.skip(static_cast<goffset>(length - keyword_length) + 4, error))
+                return false;
+
+            continue;
+        }
+
+        // Rest of the chunk data and CRC
+        if (!reader.append(out, static_cast<gsize>(length - keyword_length) + 4, error))
+            return false;
+    }
+
+    out.insert(out.end(), PNG_IEND.begin(), PNG_IEND.end());
+
+    return true;
+}
+
+// Exiv2 takes the canvas size from the start of the first image chunk, the rest is left out
+constexpr gsize WEBP_IMAGE_HEADER_LENGTH = 30;
+
+bool is_webp_image_chunk(const Exiv2::byte* type) {
+    return memcmp(type, "VP8 ", 4) == 0 || memcmp(type, "VP8L", 4) == 0 || memcmp(type, "ANMF", 4) == 0 ||
+           memcmp(type, "ALPH", 4) == 0;
+}
+
+// The metadata family a WebP chunk belongs to, or GEXIV2_OPEN_ALL if it is needed regardless
+GExiv2OpenFlags webp_chunk_family(const Exiv2::byte* type) {
+    if (memcmp(type, "EXIF", 4) == 0)
+        return GEXIV2_OPEN_EXIF;
+    if (memcmp(type, "XMP ", 4) == 0)
+        return GEXIV2_OPEN_XMP;
+
+    return GEXIV2_OPEN_ALL;
+}
+
+// Copy all chunks but the image data, of which only the headers are kept, and fix up the size
+// of the RIFF container
+bool read_webp(SegmentReader& reader, std::vector<Exiv2::byte>& out, GExiv2OpenFlags families, GError** error) {
+    if (!reader.append(out, 12, error))
+        return false;
+
+    guint64 end = static_cast<guint64>(get_uint32(out.data() + 4, true)) + 8;
+    guint64 position = 12;
+
+    while (position + 8 <= end) {
+        std::array<Exiv2::byte, 8> header{};
+        if (!reader.read(header.data(), header.size(), error))
+            return false;
+
+        position += 8;
+        guint64 length = get_uint32(header.data() + 4, true);
+        if (length > end - position) {
+            g_set_error_literal(error, g_quark_from_string("GExiv2"), 501, "Invalid WebP chunk length");
+
+            return false;
+        }
+
+        // Chunks are padded to an even length, except maybe for the last one
+        auto padded = std::min<guint64>(length + (length & 1), end - position);
+        position += padded;
+
+        if ((webp_chunk_family(header.data()) & families) == 0) {
+            if (!reader.skip(static_cast<goffset>(padded), error))
+                return false;
+
+            continue;
+        }
+
+        auto kept = padded;
+        if (is_webp_image_chunk(header.data()) && length > WEBP_IMAGE_HEADER_LENGTH) {
+            kept = WEBP_IMAGE_HEADER_LENGTH;
+            header[4] = static_cast<Exiv2::byte>(kept);
+            header[5] = header[6] = header[7] = 0;
+        }
+
+        out.insert(out.end(), header.begin(), header.end());
+        if (!reader.append(out, static_cast<gsize>(kept), error))
+            return false;
+
+        if (kept < padded && !reader.skip(static_cast<goffset>(padded - kept), error))
+            return false;
+    }
+
+    auto riff_size = static_cast<guint32>(out.size() - 8);
+    for (guint i = 0; i < 4; i++)
+        out[4 + i] = static_cast<Exiv2::byte>(riff_size >> (8 * i));
+
+    return true;
+}
+
+gsize tiff_type_size(guint16 type) {
+    switch (type) {
+        case 1: // BYTE
+        case 2: // ASCII
+        case 6: // SBYTE
+        case 7: // UNDEFINED
+            return 1;
+        case 3: // SHORT
+        case 8: // SSHORT
+            return 2;
+        case 4: // LONG
+        case 9: // SLONG
+        case 11: // FLOAT
+        case 13: // IFD
+            return 4;
+        case 5: // RATIONAL
+        case 10: // SRATIONAL
+        case 12: // DOUBLE
+            return 8;
+        default:
+            return 0;
+    }
+}
+
+#ifdef G_OS_UNIX
+// Collects the TIFF header, all IFDs reachable from it and their out-of-line values into a
+// RangeIo of the full file size. Strip and tile data is never read.
+class TiffWalker {
+  public:
+    TiffWalker(SegmentReader& reader, RangeIo& io, GExiv2OpenFlags families)
+      : _reader(reader)
+      , _io(io)
+      , _size(io.size())
+      , _families(families) {}
+
+    // Set if walk() failed without error because the ranges did not fit into the io
+    bool overflowed() const { return _overflowed; }
+
+    bool walk(GError** error) {
+        const Exiv2::byte* header = nullptr;
+        if (!load(0, 8, header, error))
+            return false;
+
+        if (header == nullptr || _size < 8)
+            return true;
+
+        _little_endian = header[0] == 'I';
+        enqueue(get_uint32(header + 4, _little_endian));
+
+        guint count = 0;
+        while (!_pending.empty() && count++ < MAX_TIFF_IFDS) {
+            auto offset = _pending.front();
+            _pending.pop_front();
+
+            if (!read_ifd(offset, error))
+                return false;
+        }
+
+        return true;
+    }
+
+  private:
+    // Reads up to length bytes at offset into the io; data is nullptr if there is nothing to
+    // read there. data is only valid until the next load.
+    bool load(guint64 offset, guint64 length, const Exiv2::byte*& data, GError** error) {
+        data = nullptr;
+        if (offset >= _size || length == 0)
+            return true;
+
+        length = std::min<guint64>(length, _size - offset);
+        auto* range = _io.add(static_cast<size_t>(offset), static_cast<size_t>(length));
+        if (range == nullptr) {
+            _overflowed = true;
+
+            return false;
+        }
+
+        if (!_reader.seek(static_cast<goffset>(offset), error) ||
+            !_reader.read(range, static_cast<gsize>(length), error))
+            return false;
+
+        data = range;
+
+        return true;
+    }
+
+    void enqueue(guint32 offset) {
+        if (offset == 0 || offset >= _size || _visited.count(offset) > 0)
+            return;
+
+        _visited.insert(offset);
+        _pending.push_back(offset);
+    }
+
+    bool read_ifd(guint32 offset, GError** error) {
+        const Exiv2::byte* data = nullptr;
+        if (!load(offset, 2, data, error))
+            return false;
+
+        if (static_cast<guint64>(offset) + 2 > _size)
+            return true;
+
+        guint64 entries = get_uint16(data, _little_endian);
+        guint64 entries_offset = static_cast<guint64>(offset) + 2;
+        const Exiv2::byte* table_data = nullptr;
+        if (!load(entries_offset, entries * 12 + 4, table_data, error))
+            return false;
+
+        if (table_data == nullptr)
+            return true;
+
+        // Loading the values below may move the range holding the entries
+        auto table_length = std::min<guint64>(entries * 12 + 4, _size - entries_offset);
+        std::vector<Exiv2::byte> table_copy(table_data, table_data + table_length);
+        const auto* table = table_copy.data();
+        guint32 thumbnail_offset = 0;
+        guint32 thumbnail_length = 0;
+
+        for (guint64 i = 0; i < entries; i++) {
+            if ((i + 1) * 12 > table_length)
+                return true;
+
+            const auto* entry = table + i * 12;
+            auto tag = get_uint16(entry, _little_endian);
+            auto type = get_uint16(entry + 2, _little_endian);
+            guint64 count = get_uint32(entry + 4, _little_endian);
+            auto value = get_uint32(entry + 8, _little_endian);
+
+            auto type_size = tiff_type_size(type);
+            if (type_size == 0)
+                continue;
+
+            // Drop embedded XMP and IPTC that is not asked for by marking the entry as empty
+            if ((tag == 0x02bc && (_families & GEXIV2_OPEN_XMP) == 0) ||
+                (tag == 0x83bb && (_families & GEXIV2_OPEN_IPTC) == 0)) {
+                _io.clear(static_cast<size_t>(entries_offset + i * 12 + 4), 8);
+                continue;
+            }
+
+            auto length = count * type_size;
+            const auto* value_data = entry + 8;
+            auto value_length = std::min<guint64>(length, 4);
+            if (length > 4) {
+                if (!load(value, length, value_data, error))
+                    return false;
+                value_length = value_data != nullptr ? std::min<guint64>(length, _size - value) : 0;
+            }
+
+            switch (tag) {
+                case 0x8769: // Exif IFD
+                case 0x8825: // GPS IFD
+                case 0xa005: // Interoperability IFD
+                    if ((_families & GEXIV2_OPEN_EXIF) != 0)
+                        enqueue(value);
+                    break;
+                case 0x014a: // SubIFDs
+                    if (type_size == 4 && (_families & GEXIV2_OPEN_EXIF) != 0) {
+                        for (guint64 n = 0; n < count && n * 4 + 4 <= value_length; n++)
+                            enqueue(get_uint32(value_data + n * 4, _little_endian));
+                    }
+                    break;
+                case 0x0201: // JPEGInterchangeFormat
+                    thumbnail_offset = value;
+                    break;
+                case 0x0202: // JPEGInterchangeFormatLength
+                    thumbnail_length = value;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // The embedded thumbnail is small and commonly asked for
+        if (!load(thumbnail_offset, thumbnail_length, data, error))
+            return false;
+
+        if (entries * 12 + 4 <= table_length)
+            enqueue(get_uint32(table + entries * 12, _little_endian));
+
+        return true;
+    }
+
+    SegmentReader& _reader;
+    RangeIo& _io;
+    size_t _size;
+    GExiv2OpenFlags _families;
+    bool _little_endian{true};
+    bool _overflowed{false};
+    std::deque<guint32> _pending;
+    std::set<guint32> _visited;
+};
+#endif
+
+// Finds the payload of the XMP APP1 segment by walking the segment headers up to the start of
+// the scan. Fails without error on an extended or a second XMP segment, where the packet is not
+// in one place.
+bool find_jpeg_xmp(SegmentReader& reader, goffset& offset, gsize& length, GError** error) {
+    constexpr gsize XMP_IDENTIFIER_LENGTH = 29;
+    bool found = false;
+
+    if (!reader.seek(2, error))
+        return false;
+
+    while (true) {
+        std::array<Exiv2::byte, 2> marker{};
+        if (!reader.read(marker.data(), marker.size(), error))
+            return false;
+
+        if (marker[0] != 0xff)
+            return false;
+
+        while (marker[1] == 0xff) {
+            if (!reader.read(&marker[1], 1, error))
+                return false;
+        }
+
+        if (marker[1] == JPEG_SOS || marker[1] == JPEG_EOI)
+            break;
+
+        if (marker[1] == 0x01 || (marker[1] >= 0xd0 && marker[1] <= 0xd7))
+            continue;
+
+        std::array<Exiv2::byte, 2 + JPEG_IDENTIFIER_LENGTH> header{};
+        if (!reader.read(header.data(), 2, error))
+            return false;
+
+        auto segment_length = get_uint16(header.data(), false);
+        if (segment_length < 2)
+            return false;
+
+        auto identifier_length = std::min<gsize>(segment_length - 2, JPEG_IDENTIFIER_LENGTH);
+        if (!reader.read(header.data() + 2, identifier_length, error))
+            return false;
+
+        const auto* identifier = header.data() + 2;
+        if (jpeg_segment_family(marker[1], identifier, identifier_length) == GEXIV2_OPEN_XMP) {
+            const char* prefix = "http://ns.adobe.com/xap/1.0/\0";
+            if (found || !has_prefix(identifier, identifier_length, prefix, XMP_IDENTIFIER_LENGTH))
+                return false;
+
+            found = true;
+            offset = reader.tell() - static_cast<goffset>(identifier_length - XMP_IDENTIFIER_LENGTH);
+            length = segment_length - 2 - XMP_IDENTIFIER_LENGTH;
+        }
+
+        if (!reader.skip(segment_length - 2 - identifier_length, error))
+            return false;
+    }
+
+    return found;
+}
+
+// Finds the value of the XMLPacket tag in the first IFD
+bool find_tiff_xmp(SegmentReader& reader, goffset& offset, gsize& length, GError** error) {
+    std::array<Exiv2::byte, 8> header{};
+    if (!reader.seek(0, error) || !reader.read(header.data(), header.size(), error))
+        return false;
+
+    bool little_endian = header[0] == 'I';
+    std::array<Exiv2::byte, 2> entries_count{};
+    if (!reader.seek(get_uint32(header.data() + 4, little_endian), error) ||
+        !reader.read(entries_count.data(), entries_count.size(), error))
+        return false;
+
+    std::vector<Exiv2::byte> entries(get_uint16(entries_count.data(), little_endian) * gsize{12});
+    if (!reader.read(entries.data(), entries.size(), error))
+        return false;
+
+    for (gsize i = 0; i < entries.size(); i += 12) {
+        const auto* entry = entries.data() + i;
+        auto type = get_uint16(entry + 2, little_endian);
+        auto count = get_uint32(entry + 4, little_endian);
+
+        // Values of up to four bytes are stored in the entry itself, too short for a packet
+        if (get_uint16(entry, little_endian) == 0x02bc) {
+            if (tiff_type_size(type) != 1 || count <= 4)
+                return false;
+
+            offset = get_uint32(entry + 8, little_endian);
+            length = count;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+namespace detail {
+
+bool find_xmp_packet(GInputStream* stream, GCancellable* cancellable, goffset& offset, gsize& length, GError** error) {
+    auto base = g_seekable_tell(G_SEEKABLE(stream));
+    SegmentReader reader{stream, cancellable, base};
+
+    std::array<Exiv2::byte, 4> signature{};
+    gsize signature_length = 0;
+    if (!g_input_stream_read_all(stream, signature.data(), signature.size(), &signature_length, cancellable, error))
+        return false;
+
+    if (signature_length < signature.size())
+        return false;
+
+    GError* inner_error = nullptr;
+    bool found = false;
+    if (signature[0] == 0xff && signature[1] == 0xd8 && signature[2] == 0xff)
+        found = find_jpeg_xmp(reader, offset, length, &inner_error);
+    else if (memcmp(signature.data(), "II*\0", 4) == 0 || memcmp(signature.data(), "MM\0*", 4) == 0)
+        found = find_tiff_xmp(reader, offset, length, &inner_error);
+
+    // A truncated file just means there is nothing to patch
+    if (g_error_matches(inner_error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT))
+        g_clear_error(&inner_error);
+
+    if (inner_error != nullptr) {
+        g_propagate_error(error, inner_error);
+
+        return false;
+    }
+
+    // The length of a TIFF value is not limited by anything else
+    if (found) {
+        if (!g_seekable_seek(G_SEEKABLE(stream), 0, G_SEEK_END, cancellable, error))
+            return false;
+
+        auto size = g_seekable_tell(G_SEEKABLE(stream)) - base;
+        found = offset >= 0 && static_cast<guint64>(offset) + length <= static_cast<guint64>(size);
+    }
+
+    return found;
+}
+
+
+Exiv2::BasicIo::UniquePtr read_metadata_segments(GInputStream* stream,
+                                                 GCancellable* cancellable,
+                                                 GExiv2OpenFlags families,
+                                                 guint64& bytes_read,
+                                                 bool& sparse,
+                                                 GError** error) {
+    auto* seekable = G_SEEKABLE(stream);
+    auto base = g_seekable_tell(seekable);
+    SegmentReader reader{stream, cancellable, base};
+
+    bytes_read = 0;
+    sparse = false;
+
+    // The EXIF thumbnail is one of the previews
+    if ((families & GEXIV2_OPEN_PREVIEWS) != 0)
+        families = static_cast<GExiv2OpenFlags>(families | GEXIV2_OPEN_EXIF);
+
+    // The signature is read again by the format specific readers below, so it is not counted
+    std::array<Exiv2::byte, 12> signature{};
+    gsize signature_length = 0;
+    if (!g_input_stream_read_all(stream, signature.data(), signature.size(), &signature_length, cancellable, error))
+        return nullptr;
+
+    if (!reader.seek(0, error))
+        return nullptr;
+
+    if (signature_length < PNG_SIGNATURE.size())
+        return nullptr;
+
+    bool is_jpeg = signature[0] == 0xff && signature[1] == 0xd8 && signature[2] == 0xff;
+    bool is_png = memcmp(signature.data(), PNG_SIGNATURE.data(), PNG_SIGNATURE.size()) == 0;
+    bool is_webp = signature_length == signature.size() && memcmp(signature.data(), "RIFF", 4) == 0 &&
+                   memcmp(signature.data() + 8, "WEBP", 4) == 0;
+    bool is_tiff = memcmp(signature.data(), "II*\0", 4) == 0 || memcmp(signature.data(), "MM\0*", 4) == 0;
+
+    if (is_jpeg || is_png || is_webp) {
+        std::vector<Exiv2::byte> out;
+        bool success = false;
+        if (is_jpeg)
+            success = read_jpeg(reader, out, families, error);
+        else if (is_png)
+            success = read_png(reader, out, families, error);
+        else
+            success = read_webp(reader, out, families, error);
+        bytes_read = reader.bytes_read();
+        if (!success)
+            return nullptr;
+
+        auto io = std::make_unique<Exiv2::MemIo>();
+        io->write(out.data(), out.size());
+        io->seek(0, Exiv2::BasicIo::beg);
+
+        return io;
+    }
+
+#ifdef G_OS_UNIX
+    // The previews of TIFF files are stored like the image data, so a sparse read would lose them
+    if (is_tiff && (families & GEXIV2_OPEN_PREVIEWS) == 0) {
+        if (!g_seekable_seek(seekable, 0, G_SEEK_END, cancellable, error))
+            return nullptr;
+
+        auto io = std::make_unique<RangeIo>(static_cast<size_t>(g_seekable_tell(seekable) - base));
+        TiffWalker walker{reader, *io, families};
+        auto success = walker.walk(error);
+        bytes_read = reader.bytes_read();
+        if (!success) {
+            // Whatever confused the walk is left to Exiv2 reading the whole file
+            if (walker.overflowed())
+                reader.seek(0, error);
+
+            return nullptr;
+        }
+
+        sparse = true;
+
+        return io;
+    }
+#else
+    (void) is_tiff;
+#endif
+
+    return nullptr;
+}
+
+} // namespace detail
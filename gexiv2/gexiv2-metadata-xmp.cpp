@@ -15,12 +15,43 @@
 
 #include "gexiv2-metadata-private.h"
 #include "gexiv2-metadata.h"
+#include "gexiv2-startup-private.h"
 #include "gexiv2-util-private.h"
 
 #include <exiv2/exiv2.hpp>
 #include <glib-object.h>
 #include <string>
 
+namespace {
+// Exiv2 only locks single registry calls, this keeps a lookup and the change that depends on it together
+GRWLock xmp_namespaces_lock;
+
+// The registry functions are static and may be the first to touch XMP, so both lockers make sure
+// the toolkit was initialized with its lock before Exiv2 does so lazily without one
+
+class NamespacesReadLocker {
+  public:
+    NamespacesReadLocker() {
+        gexiv2_initialize_xmp();
+        g_rw_lock_reader_lock(&xmp_namespaces_lock);
+    }
+    ~NamespacesReadLocker() { g_rw_lock_reader_unlock(&xmp_namespaces_lock); }
+    NamespacesReadLocker(const NamespacesReadLocker&) = delete;
+    NamespacesReadLocker& operator=(const NamespacesReadLocker&) = delete;
+};
+
+class NamespacesWriteLocker {
+  public:
+    NamespacesWriteLocker() {
+        gexiv2_initialize_xmp();
+        g_rw_lock_writer_lock(&xmp_namespaces_lock);
+    }
+    ~NamespacesWriteLocker() { g_rw_lock_writer_unlock(&xmp_namespaces_lock); }
+    NamespacesWriteLocker(const NamespacesWriteLocker&) = delete;
+    NamespacesWriteLocker& operator=(const NamespacesWriteLocker&) = delete;
+};
+} // namespace
+
 G_BEGIN_DECLS
 
 gboolean gexiv2_metadata_has_xmp (GExiv2Metadata *self) {
@@ -40,6 +71,7 @@ void gexiv2_metadata_clear_xmp(GExiv2Metadata *self) {
     g_return_if_fail(priv->image.get() != nullptr);
 
     priv->image->xmpData().clear();
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
 }
 
 gchar *gexiv2_metadata_generate_xmp_packet(GExiv2Metadata *self,
@@ -99,14 +131,7 @@ gboolean gexiv2_metadata_has_xmp_tag(GExiv2Metadata *self, const gchar* tag) {
 
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
 
-    Exiv2::XmpData& xmp_data = priv->image->xmpData();
-
-    for (Exiv2::XmpData::iterator it = xmp_data.begin(); it != xmp_data.end(); ++it) {
-        if (it->count() > 0 && g_ascii_strcasecmp(tag, it->key().c_str()) == 0)
-            return TRUE;
-    }
-    
-    return FALSE;
+    return priv->tag_index->contains(GEXIV2_OPEN_XMP, priv->image->xmpData(), tag);
 }
 
 gboolean gexiv2_metadata_clear_xmp_tag(GExiv2Metadata *self, const gchar* tag) {
@@ -118,6 +143,10 @@ gboolean gexiv2_metadata_clear_xmp_tag(GExiv2Metadata *self, const gchar* tag) {
 
     Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+    // Spares the walk over all entries for tags that are not there
+    if (!priv->tag_index->contains(GEXIV2_OPEN_XMP, xmp_data, tag))
+        return FALSE;
+
     gboolean erased = FALSE;
     
     Exiv2::XmpData::iterator it = xmp_data.begin();
@@ -129,7 +158,10 @@ gboolean gexiv2_metadata_clear_xmp_tag(GExiv2Metadata *self, const gchar* tag) {
             it++;
         }
     }
-    
+
+    if (erased)
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
+
     return erased;
 }
 
@@ -139,36 +171,25 @@ gchar** gexiv2_metadata_get_xmp_tags (GExiv2Metadata *self) {
 
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
 
-    // get a copy of the original XmpData and sort it by key, preserving the original
-    Exiv2::XmpData xmp_data = Exiv2::XmpData(priv->image->xmpData());
-    detail::sortMetadata(xmp_data);
+    return detail::keys_to_strv(priv->tag_index->sorted_keys(GEXIV2_OPEN_XMP, priv->image->xmpData()));
+}
 
-    GSList* list = nullptr;
-    GSList* list_iter = nullptr;
-    gchar** data = nullptr;
-    gint count = 0;
-    
-    for (Exiv2::XmpData::iterator it = xmp_data.begin(); it != xmp_data.end(); ++it) {
-        if (it->count() > 0) {
-            list = g_slist_prepend (list, g_strdup (it->key ().c_str ()));
-            count++;
-        }
-    }
+gchar* gexiv2_metadata_get_xmp_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+    g_return_val_if_fail(tag != nullptr, nullptr);
 
-    data = g_new (gchar*, count + 1);
-    data[count--] = nullptr;
-    for (list_iter = list; list_iter != nullptr; list_iter = list_iter->next) {
-        data[count--] = static_cast<gchar*>(list_iter->data);
+    try {
+        return gexiv2_metadata_get_xmp_tag_string(self, Exiv2::XmpKey(tag), error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
     }
 
-    g_slist_free (list);
-
-    return data;
+    return nullptr;
 }
 
-gchar* gexiv2_metadata_get_xmp_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
+gchar* gexiv2_metadata_get_xmp_tag_string(GExiv2Metadata* self, const Exiv2::XmpKey& key, GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
-    g_return_val_if_fail(tag != nullptr, nullptr);
     auto* priv = gexiv2_priv(self);
 
     g_return_val_if_fail(priv != nullptr, nullptr);
@@ -178,7 +199,7 @@ gchar* gexiv2_metadata_get_xmp_tag_string (GExiv2Metadata *self, const gchar* ta
     try {
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
-        Exiv2::XmpData::iterator it = xmp_data.findKey(Exiv2::XmpKey(tag));
+        Exiv2::XmpData::iterator it = xmp_data.findKey(key);
         while (it != xmp_data.end() && it->count() == 0)
             it++;
         
@@ -260,6 +281,7 @@ gboolean gexiv2_metadata_set_xmp_tag_struct (GExiv2Metadata *self, const gchar*
     }
 
     try {
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
         xmp_data.add(Exiv2::XmpKey(tag), &tv);
         return TRUE;
     } catch (Exiv2::Error& e) {
@@ -277,8 +299,24 @@ gboolean gexiv2_metadata_try_set_xmp_tag_struct (GExiv2Metadata *self, const gch
 
 gboolean gexiv2_metadata_set_xmp_tag_string (GExiv2Metadata *self, const gchar* tag, 
     const gchar* value, GError **error) {
-    g_return_val_if_fail(GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(tag != NULL, FALSE);
+
+    try {
+        return gexiv2_metadata_set_xmp_tag_string(self, Exiv2::XmpKey(tag), value, error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_set_xmp_tag_string(GExiv2Metadata* self,
+                                            const Exiv2::XmpKey& key,
+                                            const gchar* value,
+                                            GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA (self), FALSE);
     g_return_val_if_fail(value != NULL, FALSE);
     auto* priv = gexiv2_priv(self);
 
@@ -286,7 +324,8 @@ gboolean gexiv2_metadata_set_xmp_tag_string (GExiv2Metadata *self, const gchar*
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
     
     try {
-        priv->image->xmpData()[tag] = value;
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
+        detail::datum_for_key<Exiv2::Xmpdatum>(priv->image->xmpData(), key) = value;
 
         return TRUE;
     } catch (Exiv2::Error& e) {
@@ -299,8 +338,21 @@ gboolean gexiv2_metadata_set_xmp_tag_string (GExiv2Metadata *self, const gchar*
 }
 
 glong gexiv2_metadata_get_xmp_tag_long (GExiv2Metadata *self, const gchar* tag, GError **error) {
-    g_return_val_if_fail(GEXIV2_IS_METADATA (self), 0);
     g_return_val_if_fail(tag != nullptr, 0);
+
+    try {
+        return gexiv2_metadata_get_xmp_tag_long(self, Exiv2::XmpKey(tag), error);
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return 0;
+}
+
+glong gexiv2_metadata_get_xmp_tag_long(GExiv2Metadata* self, const Exiv2::XmpKey& key, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA (self), 0);
     auto* priv = gexiv2_priv(self);
 
     g_return_val_if_fail(priv != nullptr, 0);
@@ -310,7 +362,7 @@ glong gexiv2_metadata_get_xmp_tag_long (GExiv2Metadata *self, const gchar* tag,
     try {
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
-        Exiv2::XmpData::iterator it = xmp_data.findKey(Exiv2::XmpKey(tag));
+        Exiv2::XmpData::iterator it = xmp_data.findKey(key);
         while (it != xmp_data.end() && it->count() == 0)
             it++;
 
@@ -334,6 +386,7 @@ gboolean gexiv2_metadata_set_xmp_tag_long (GExiv2Metadata *self, const gchar* ta
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
     
     try {
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
         priv->image->xmpData()[tag] = value;
 
         return TRUE;
@@ -487,6 +540,8 @@ gboolean gexiv2_metadata_set_xmp_tag_multiple (GExiv2Metadata *self, const gchar
     try {
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_XMP);
+
         /* first clear existing tag */
         Exiv2::XmpData::iterator it = xmp_data.findKey(Exiv2::XmpKey(tag));
         while (it != xmp_data.end() && it->count() == 0)
@@ -515,7 +570,9 @@ gboolean gexiv2_metadata_set_xmp_tag_multiple (GExiv2Metadata *self, const gchar
 const gchar* gexiv2_metadata_get_xmp_tag_label (const gchar* tag, GError **error) {
     g_return_val_if_fail(tag != NULL, NULL);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
-    
+
+    NamespacesReadLocker locker;
+
     try {
         return Exiv2::XmpProperties::propertyTitle(Exiv2::XmpKey(tag));
     } catch (Exiv2::Error& e) {
@@ -530,7 +587,9 @@ const gchar* gexiv2_metadata_get_xmp_tag_label (const gchar* tag, GError **error
 const gchar* gexiv2_metadata_get_xmp_tag_description (const gchar* tag, GError **error) {
     g_return_val_if_fail(tag != NULL, NULL);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
-    
+
+    NamespacesReadLocker locker;
+
     try {
         return Exiv2::XmpProperties::propertyDesc(Exiv2::XmpKey(tag));
     } catch (Exiv2::Error& e) {
@@ -545,7 +604,9 @@ const gchar* gexiv2_metadata_get_xmp_tag_description (const gchar* tag, GError *
 const gchar* gexiv2_metadata_get_xmp_tag_type (const gchar* tag, GError **error) {
     g_return_val_if_fail(tag != NULL, NULL);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
-    
+
+    NamespacesReadLocker locker;
+
     try {
         return Exiv2::TypeInfo::typeName(Exiv2::XmpProperties::propertyType(Exiv2::XmpKey(tag)));
     } catch (Exiv2::Error& e) {
@@ -646,6 +707,8 @@ gboolean gexiv2_metadata_register_xmp_namespace(const gchar* name, const gchar*
     g_return_val_if_fail(prefix != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    NamespacesWriteLocker locker;
+
     try {
         Exiv2::XmpProperties::ns(prefix);
     } catch (Exiv2::Error& e1) {
@@ -669,6 +732,8 @@ gboolean gexiv2_metadata_unregister_xmp_namespace(const gchar* name, GError** er
     g_return_val_if_fail(name != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    NamespacesWriteLocker locker;
+
     try {
         std::string prefix = Exiv2::XmpProperties::prefix(name);
 
@@ -700,6 +765,8 @@ void gexiv2_metadata_try_unregister_all_xmp_namespaces (GError **error) {
 void gexiv2_metadata_unregister_all_xmp_namespaces(GError** error) {
     g_return_if_fail(error == nullptr || *error == nullptr);
 
+    NamespacesWriteLocker locker;
+
     try {
         Exiv2::XmpProperties::unregisterNs();
     } catch (Exiv2::Error& e) {
@@ -720,6 +787,7 @@ char* gexiv2_metadata_get_xmp_namespace_for_tag(const char* tag, GError** error)
 
     char** list = nullptr;
     char* result = nullptr;
+    NamespacesReadLocker locker;
 
     try {
         list = g_strsplit(tag, ".", 3);
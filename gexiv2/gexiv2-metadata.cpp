@@ -23,61 +23,39 @@
 #include "gexiv2-preview-image.h"
 #include "gexiv2-preview-properties-private.h"
 #include "gexiv2-preview-properties.h"
+#include "gexiv2-startup-private.h"
+#include "gexiv2-tag-id-private.h"
+#include "gexiv2-tag-iter-private.h"
 #include "gexiv2-util-private.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstring>
+#include <fcntl.h>
 #include <gio/gio.h>
 #include <glib-object.h>
+#include <glib/gstdio.h>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #ifdef G_OS_WIN32
 #include <glib/gwin32.h>
+#include <io.h>
+#endif
+
+#ifdef G_OS_UNIX
+#include <cstdlib>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include <exiv2/exiv2.hpp>
 
 using image_ptr = Exiv2::Image::UniquePtr;
 
-// -----------------------------------------------------------------------------
-// Misc internal helper functions
-
-// Port of the NaturalCollate.vala collation key generation to C++
-// Simplified to assume that all XMP keys are ASCII and not UTF-8
-// Original source:
-// https://gitlab.gnome.org/GNOME/shotwell/-/blob/master/src/NaturalCollate.vala
-std::string detail::collate_key(const std::string& str) {
-    constexpr char SUPERDIGIT = ':';
-    constexpr char COLLATION_SENTINAL[] = "\x01\x01\x01";
-    constexpr char NUM_SENTINEL = 0x2;
-
-    std::stringstream in{str};
-    std::stringstream out{};
-
-    while (not in.eof()) {
-        // As long as there are no digits, we put them from input to output
-        while (not std::isdigit(in.peek()) && not in.eof()) {
-            out << static_cast<char>(in.get());
-        }
-
-        if (not in.eof()) {
-
-            // We read the number (integer only)...
-            uint64_t number;
-            in >> number;
-
-            std::string to_append(std::to_string(number).length(), SUPERDIGIT);
-
-            // ... and append it together with its length in : to the output
-            out << COLLATION_SENTINAL << NUM_SENTINEL << to_append << number;
-        }
-    }
-
-    // Add a sentinal for good measure (no idea, follows the original code)
-    out << NUM_SENTINEL;
-
-    return out.str();
-}
-
 G_BEGIN_DECLS
 
 G_DEFINE_TYPE_WITH_PRIVATE(GExiv2Metadata, gexiv2_metadata, G_TYPE_OBJECT);
@@ -89,17 +67,29 @@ GExiv2MetadataPrivate* gexiv2_priv(GExiv2Metadata* self) {
 static void gexiv2_metadata_finalize(GObject* object);
 static void gexiv2_metadata_set_comment_internal(GExiv2Metadata* self, const gchar* new_comment);
 
-static gboolean gexiv2_metadata_open_internal(GExiv2Metadata* self, GError** error);
-static gboolean gexiv2_metadata_save_internal(GExiv2Metadata* self, image_ptr image, GError** error);
+static gboolean gexiv2_metadata_open_internal(GExiv2Metadata* self, GCancellable* cancellable, GError** error);
+static gboolean gexiv2_metadata_save_internal(GExiv2Metadata* self,
+                                              const image_ptr& image,
+                                              GExiv2OpenFlags families,
+                                              GError** error);
 
 static void gexiv2_metadata_init(GExiv2Metadata* self) {
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
 
     /* Initialize members */
     priv->comment = nullptr;
+    priv->comment_buffer = nullptr;
+    priv->comment_capacity = 0;
     priv->mime_type = nullptr;
     priv->preview_manager = nullptr;
     priv->preview_properties = nullptr;
+    priv->metadata_only = FALSE;
+    priv->skip_previews = FALSE;
+    priv->previews_loaded = FALSE;
+    priv->loaded_families = GEXIV2_OPEN_ALL;
+    priv->tag_index = new detail::TagIndex();
+    priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
+    priv->path = nullptr;
     priv->pixel_width = -1;
     priv->pixel_height = -1;
 
@@ -118,48 +108,97 @@ static void gexiv2_metadata_init(GExiv2Metadata* self) {
 static void gexiv2_metadata_class_init(GExiv2MetadataClass* klass) {
     GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
 
+    // For applications that never call gexiv2_initialize()
+    gexiv2_log_init();
+    gexiv2_initialize_xmp();
+
     gobject_class->finalize = gexiv2_metadata_finalize;
 }
 
 static void gexiv2_metadata_free_impl(GExiv2MetadataPrivate* priv) {
     delete priv->preview_manager;
+    priv->preview_manager = nullptr;
 
     if (priv->preview_properties != NULL) {
         int ctr = 0;
         while (priv->preview_properties[ctr] != NULL)
             g_object_unref(priv->preview_properties[ctr++]);
 
-        g_free(priv->preview_properties);
+        g_clear_pointer(&priv->preview_properties, g_free);
     }
 
     if (priv->image.get() != NULL)
         priv->image.reset();
+
+    priv->metadata_only = FALSE;
+    priv->skip_previews = FALSE;
+    priv->previews_loaded = FALSE;
+    priv->loaded_families = GEXIV2_OPEN_ALL;
+    g_clear_pointer(&priv->path, g_free);
+
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_ALL);
+    priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
 }
 
 static void gexiv2_metadata_finalize(GObject* object) {
     GExiv2Metadata* self = GEXIV2_METADATA(object);
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
 
-    g_free(priv->comment);
-    g_free(priv->mime_type);
+    g_free(priv->comment_buffer);
 
     gexiv2_metadata_free_impl(priv);
 
+    delete priv->tag_index;
+    priv->tag_index = nullptr;
+
     G_OBJECT_CLASS (gexiv2_metadata_parent_class)->finalize (object);
 }
 
+void gexiv2_metadata_tags_changed(GExiv2MetadataPrivate* priv, GExiv2OpenFlags families) {
+    priv->tag_index->invalidate(families);
+    priv->dirty_families = static_cast<GExiv2OpenFlags>(priv->dirty_families | families);
+}
+
 GExiv2Metadata* gexiv2_metadata_new(void) {
     return GEXIV2_METADATA(g_object_new(GEXIV2_TYPE_METADATA, NULL));
 }
 
+void gexiv2_metadata_reset(GExiv2Metadata* self) {
+    g_return_if_fail(GEXIV2_IS_METADATA(self));
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+
+    // The comment buffer and the tag index stay allocated for the next file
+    gexiv2_metadata_free_impl(priv);
+    gexiv2_metadata_set_comment_internal(self, nullptr);
+    priv->mime_type = nullptr;
+    priv->pixel_width = -1;
+    priv->pixel_height = -1;
+    priv->supports_exif = FALSE;
+    priv->supports_xmp = FALSE;
+    priv->supports_iptc = FALSE;
+}
+
 static void gexiv2_metadata_set_comment_internal(GExiv2Metadata* self, const gchar* new_comment) {
     g_return_if_fail(GEXIV2_IS_METADATA(self));
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
     g_return_if_fail(priv != nullptr);
 
-    g_free(priv->comment);
+    if (new_comment == nullptr) {
+        priv->comment = nullptr;
 
-    priv->comment = g_strdup(new_comment);
+        return;
+    }
+
+    // The buffer is reused, so reading comments of many files does not allocate each time
+    auto size = strlen(new_comment) + 1;
+    if (size > priv->comment_capacity) {
+        g_free(priv->comment_buffer);
+        priv->comment_buffer = g_new(gchar, size);
+        priv->comment_capacity = size;
+    }
+
+    memmove(priv->comment_buffer, new_comment, size);
+    priv->comment = priv->comment_buffer;
 }
 
 static void gexiv2_metadata_init_internal(GExiv2Metadata* self, GError** error) {
@@ -172,9 +211,12 @@ static void gexiv2_metadata_init_internal(GExiv2Metadata* self, GError** error)
 
     try {
 
-        gexiv2_metadata_set_comment_internal(self, priv->image->comment().c_str());
-        g_clear_pointer(&priv->mime_type, g_free);
-        priv->mime_type = g_strdup(priv->image->mimeType().c_str());
+        if (priv->loaded_families & GEXIV2_OPEN_COMMENT)
+            gexiv2_metadata_set_comment_internal(self, priv->image->comment().c_str());
+        else
+            gexiv2_metadata_set_comment_internal(self, nullptr);
+        // There are only a few distinct MIME types, interning them saves a copy per file
+        priv->mime_type = g_intern_string(priv->image->mimeType().c_str());
 
         priv->pixel_width = priv->image->pixelWidth();
         priv->pixel_height = priv->image->pixelHeight();
@@ -188,6 +230,29 @@ static void gexiv2_metadata_init_internal(GExiv2Metadata* self, GError** error)
         mode = priv->image->checkMode(Exiv2::mdIptc);
         priv->supports_iptc = (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite);
 
+        // Whatever was just read is what the source has
+        priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
+
+    } catch (Exiv2::Error& e) {
+        priv->mime_type = nullptr;
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+}
+
+// Enumerating the previews may seek around in the file, so it is only done once they are asked for
+static gboolean gexiv2_metadata_ensure_previews(GExiv2Metadata* self, GError** error) {
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+
+    if (priv->previews_loaded)
+        return priv->preview_manager != nullptr;
+
+    priv->previews_loaded = TRUE;
+    if (priv->skip_previews)
+        return FALSE;
+
+    try {
         priv->preview_manager = new Exiv2::PreviewManager(*priv->image.get());
 
         Exiv2::PreviewPropertiesList list = priv->preview_manager->getPreviewProperties();
@@ -197,16 +262,19 @@ static void gexiv2_metadata_init_internal(GExiv2Metadata* self, GError** error)
                 priv->preview_properties[ctr] = gexiv2_preview_properties_new(list[ctr]);
             priv->preview_properties[count] = nullptr;
         }
+
+        return TRUE;
     } catch (Exiv2::Error& e) {
-        g_clear_pointer(&priv->mime_type, g_free);
         g_clear_pointer(&priv->preview_manager, [](gpointer p) { delete reinterpret_cast<Exiv2::PreviewManager*>(p); });
         error << e;
     } catch (std::exception& e) {
         error << e;
     }
+
+    return FALSE;
 }
 
-static gboolean gexiv2_metadata_open_internal (GExiv2Metadata* self, GError** error) {
+static gboolean gexiv2_metadata_open_internal(GExiv2Metadata* self, GCancellable* cancellable, GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
     g_return_val_if_fail(priv != nullptr, FALSE);
@@ -219,11 +287,33 @@ static gboolean gexiv2_metadata_open_internal (GExiv2Metadata* self, GError** er
 
     try {
         priv->image->readMetadata();
+
+        // Reading the metadata is the expensive part; do not bother with the rest if
+        // nobody is interested in the result anymore
+        if (g_cancellable_set_error_if_cancelled(cancellable, error)) {
+            priv->image.reset();
+
+            return FALSE;
+        }
+
+        // Formats where the unwanted parts could not be skipped while reading
+        if (!(priv->loaded_families & GEXIV2_OPEN_EXIF))
+            priv->image->clearExifData();
+        if (!(priv->loaded_families & GEXIV2_OPEN_XMP))
+            priv->image->clearXmpData();
+        if (!(priv->loaded_families & GEXIV2_OPEN_IPTC))
+            priv->image->clearIptcData();
+        if (!(priv->loaded_families & GEXIV2_OPEN_PREVIEWS))
+            priv->skip_previews = TRUE;
+
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_ALL);
+
         gexiv2_metadata_init_internal(self, error);
 
         return !(error && *error);
     } catch (Exiv2::Error& e) {
-        error << e;
+        if (!g_cancellable_set_error_if_cancelled(cancellable, error))
+            error << e;
     } catch (std::exception& e) {
         error << e;
     }
@@ -254,8 +344,10 @@ static std::string convert_path(const char* path, GError** error) {
 #endif
 }
 
-gboolean gexiv2_metadata_open_path(GExiv2Metadata* self, const gchar* path, GError** error) {
-    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+static gboolean gexiv2_metadata_open_path_internal(GExiv2Metadata* self,
+                                                   const gchar* path,
+                                                   GCancellable* cancellable,
+                                                   GError** error) {
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
 
     gexiv2_metadata_free_impl(priv);
@@ -271,7 +363,12 @@ gboolean gexiv2_metadata_open_path(GExiv2Metadata* self, const gchar* path, GErr
         }
         priv->image = Exiv2::ImageFactory::open(converted_path);
 
-        return gexiv2_metadata_open_internal (self, error);
+        if (!gexiv2_metadata_open_internal(self, cancellable, error))
+            return FALSE;
+
+        priv->path = g_strdup(path);
+
+        return TRUE;
     } catch (Exiv2::Error &e) {
         error << e;
     }
@@ -282,6 +379,55 @@ gboolean gexiv2_metadata_open_path(GExiv2Metadata* self, const gchar* path, GErr
     return FALSE;
 }
 
+gboolean gexiv2_metadata_open_path(GExiv2Metadata* self, const gchar* path, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+
+    return gexiv2_metadata_open_path_internal(self, path, nullptr, error);
+}
+
+static void gexiv2_metadata_open_path_thread(GTask* task,
+                                             gpointer source_object,
+                                             gpointer task_data,
+                                             GCancellable* cancellable) {
+    auto* self = GEXIV2_METADATA(source_object);
+    auto* path = static_cast<const gchar*>(task_data);
+    GError* error = nullptr;
+
+    if (g_task_return_error_if_cancelled(task))
+        return;
+
+    if (gexiv2_metadata_open_path_internal(self, path, cancellable, &error))
+        g_task_return_boolean(task, TRUE);
+    else if (error != nullptr)
+        g_task_return_error(task, error);
+    else
+        g_task_return_new_error(task, g_quark_from_string("GExiv2"), 501, "Failed to open %s", path);
+}
+
+void gexiv2_metadata_open_path_async(GExiv2Metadata* self,
+                                     const gchar* path,
+                                     GCancellable* cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data) {
+    g_return_if_fail(GEXIV2_IS_METADATA(self));
+    g_return_if_fail(path != nullptr);
+    g_return_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable));
+
+    GTask* task = g_task_new(self, cancellable, callback, user_data);
+    g_task_set_source_tag(task, reinterpret_cast<gpointer>(gexiv2_metadata_open_path_async));
+    g_task_set_task_data(task, g_strdup(path), g_free);
+    g_task_run_in_thread(task, gexiv2_metadata_open_path_thread);
+    g_object_unref(task);
+}
+
+gboolean gexiv2_metadata_open_path_finish(GExiv2Metadata* self, GAsyncResult* result, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
 gboolean gexiv2_metadata_open_buf(GExiv2Metadata* self, const guint8* data, glong n_data, GError** error) {
     g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
@@ -291,7 +437,7 @@ gboolean gexiv2_metadata_open_buf(GExiv2Metadata* self, const guint8* data, glon
     try {
         priv->image = Exiv2::ImageFactory::open(data, n_data);
 
-        return gexiv2_metadata_open_internal (self, error);
+        return gexiv2_metadata_open_internal(self, nullptr, error);
     } catch (Exiv2::Error &e) {
         g_set_error_literal (error, g_quark_from_string ("GExiv2"), 501, "unsupported format");
     } catch (std::exception& e) {
@@ -301,9 +447,10 @@ gboolean gexiv2_metadata_open_buf(GExiv2Metadata* self, const guint8* data, glon
     return FALSE;
 }
 
-gboolean gexiv2_metadata_from_stream(GExiv2Metadata *self, GInputStream *stream, GError **error) {
-    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
-
+static gboolean gexiv2_metadata_from_stream_internal(GExiv2Metadata* self,
+                                                     GInputStream* stream,
+                                                     GCancellable* cancellable,
+                                                     GError** error) {
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
     gexiv2_metadata_free_impl(priv);
 
@@ -313,16 +460,241 @@ gboolean gexiv2_metadata_from_stream(GExiv2Metadata *self, GInputStream *stream,
     }
 
     try {
-        GExiv2::GioIo::ptr_type gio_ptr{new GExiv2::GioIo(stream)};
+        GExiv2::GioIo::ptr_type gio_ptr{new GExiv2::GioIo(stream, cancellable)};
         priv->image = Exiv2::ImageFactory::open(std::move(gio_ptr));
 
-        return gexiv2_metadata_open_internal (self, error);
+        return gexiv2_metadata_open_internal(self, cancellable, error);
     } catch (Exiv2::Error &e) {
+        if (!g_cancellable_set_error_if_cancelled(cancellable, error))
+            error << e;
+    } catch (std::exception& e) {
         error << e;
+    }
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_from_stream(GExiv2Metadata *self, GInputStream *stream, GError **error) {
+    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
+
+    return gexiv2_metadata_from_stream_internal(self, stream, nullptr, error);
+}
+
+static void gexiv2_metadata_from_stream_thread(GTask* task,
+                                               gpointer source_object,
+                                               gpointer task_data,
+                                               GCancellable* cancellable) {
+    auto* self = GEXIV2_METADATA(source_object);
+    auto* stream = G_INPUT_STREAM(task_data);
+    GError* error = nullptr;
+
+    if (g_task_return_error_if_cancelled(task))
+        return;
+
+    if (gexiv2_metadata_from_stream_internal(self, stream, cancellable, &error))
+        g_task_return_boolean(task, TRUE);
+    else if (error != nullptr)
+        g_task_return_error(task, error);
+    else
+        g_task_return_new_error(task, g_quark_from_string("GExiv2"), 501, "unsupported format");
+}
+
+void gexiv2_metadata_from_stream_async(GExiv2Metadata* self,
+                                       GInputStream* stream,
+                                       GCancellable* cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data) {
+    g_return_if_fail(GEXIV2_IS_METADATA(self));
+    g_return_if_fail(G_IS_INPUT_STREAM(stream));
+    g_return_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable));
+
+    GTask* task = g_task_new(self, cancellable, callback, user_data);
+    g_task_set_source_tag(task, reinterpret_cast<gpointer>(gexiv2_metadata_from_stream_async));
+    g_task_set_task_data(task, g_object_ref(stream), g_object_unref);
+    g_task_run_in_thread(task, gexiv2_metadata_from_stream_thread);
+    g_object_unref(task);
+}
+
+gboolean gexiv2_metadata_from_stream_finish(GExiv2Metadata* self, GAsyncResult* result, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+// With metadata_only, previews that are stored like the image data are dropped instead of
+// reading the whole file for them
+static gboolean gexiv2_metadata_from_stream_metadata_only_internal(GExiv2Metadata* self,
+                                                                   GInputStream* stream,
+                                                                   GExiv2OpenFlags families,
+                                                                   gboolean metadata_only,
+                                                                   GCancellable* cancellable,
+                                                                   guint64* bytes_read,
+                                                                   GError** error) {
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    gexiv2_metadata_free_impl(priv);
+
+    if (!G_IS_SEEKABLE(stream) || !g_seekable_can_seek(G_SEEKABLE(stream))) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVAL, "Passed stream is not seekable");
+        return FALSE;
+    }
+
+    guint64 segments_read = 0;
+    GExiv2::GioIo* gio = nullptr;
+
+    try {
+        GError* inner_error = nullptr;
+        bool sparse = false;
+
+        priv->loaded_families = families;
+
+        auto segment_families = families;
+        if (metadata_only)
+            segment_families = static_cast<GExiv2OpenFlags>(families & ~GEXIV2_OPEN_PREVIEWS);
+
+        auto io = detail::read_metadata_segments(stream, cancellable, segment_families, segments_read, sparse,
+                                                 &inner_error);
+        if (inner_error != nullptr) {
+            if (bytes_read != nullptr)
+                *bytes_read = segments_read;
+            g_propagate_error(error, inner_error);
+
+            return FALSE;
+        }
+
+        if (io) {
+            priv->metadata_only = TRUE;
+            priv->skip_previews = sparse;
+        } else {
+            // Not a format we know the layout of or TIFF with previews, read it like
+            // gexiv2_metadata_from_stream() does
+            gio = new GExiv2::GioIo(stream, cancellable);
+            io.reset(gio);
+        }
+
+        priv->image = Exiv2::ImageFactory::open(std::move(io));
+
+        auto result = gexiv2_metadata_open_internal(self, cancellable, error);
+        if (bytes_read != nullptr)
+            *bytes_read = segments_read + (gio != nullptr ? gio->bytes_read() : 0);
+
+        return result;
+    } catch (Exiv2::Error& e) {
+        if (!g_cancellable_set_error_if_cancelled(cancellable, error))
+            error << e;
     } catch (std::exception& e) {
         error << e;
     }
 
+    if (bytes_read != nullptr)
+        *bytes_read = segments_read;
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_from_stream_metadata_only(GExiv2Metadata* self,
+                                                   GInputStream* stream,
+                                                   guint64* bytes_read,
+                                                   GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    return gexiv2_metadata_from_stream_metadata_only_internal(self, stream, GEXIV2_OPEN_ALL, TRUE, nullptr,
+                                                              bytes_read, error);
+}
+
+gboolean gexiv2_metadata_open_path_metadata_only(GExiv2Metadata* self,
+                                                 const gchar* path,
+                                                 guint64* bytes_read,
+                                                 GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    if (bytes_read != nullptr)
+        *bytes_read = 0;
+
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+    g_autoptr(GFileInputStream) stream = g_file_read(file, nullptr, error);
+    if (stream == nullptr)
+        return FALSE;
+
+    if (!gexiv2_metadata_from_stream_metadata_only_internal(self, G_INPUT_STREAM(stream), GEXIV2_OPEN_ALL, TRUE,
+                                                            nullptr, bytes_read, error))
+        return FALSE;
+
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    priv->path = g_strdup(path);
+
+    return TRUE;
+}
+
+gboolean gexiv2_metadata_from_stream_with_flags(GExiv2Metadata* self,
+                                                GInputStream* stream,
+                                                GExiv2OpenFlags flags,
+                                                GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(G_IS_INPUT_STREAM(stream), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    // Everything is asked for, so the image is read as a whole and can be saved again
+    if ((flags & GEXIV2_OPEN_ALL) == GEXIV2_OPEN_ALL)
+        return gexiv2_metadata_from_stream_internal(self, stream, nullptr, error);
+
+    return gexiv2_metadata_from_stream_metadata_only_internal(self, stream, flags, FALSE, nullptr, nullptr, error);
+}
+
+gboolean gexiv2_metadata_open_path_with_flags(GExiv2Metadata* self,
+                                              const gchar* path,
+                                              GExiv2OpenFlags flags,
+                                              GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    if ((flags & GEXIV2_OPEN_ALL) == GEXIV2_OPEN_ALL)
+        return gexiv2_metadata_open_path_internal(self, path, nullptr, error);
+
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+    g_autoptr(GFileInputStream) stream = g_file_read(file, nullptr, error);
+    if (stream == nullptr)
+        return FALSE;
+
+    if (!gexiv2_metadata_from_stream_metadata_only_internal(self, G_INPUT_STREAM(stream), flags, FALSE, nullptr,
+                                                            nullptr, error))
+        return FALSE;
+
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    priv->path = g_strdup(path);
+
+    return TRUE;
+}
+
+GExiv2OpenFlags gexiv2_metadata_get_open_flags(GExiv2Metadata* self) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), GEXIV2_OPEN_ALL);
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+
+    return priv->loaded_families;
+}
+
+gboolean gexiv2_metadata_check_family_loaded(GExiv2Metadata* self, const gchar* tag, GError** error) {
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    const gchar* family = nullptr;
+
+    if (gexiv2_metadata_is_exif_tag(tag) && !(priv->loaded_families & GEXIV2_OPEN_EXIF))
+        family = "EXIF";
+    else if (gexiv2_metadata_is_xmp_tag(tag) && !(priv->loaded_families & GEXIV2_OPEN_XMP))
+        family = "XMP";
+    else if (gexiv2_metadata_is_iptc_tag(tag) && !(priv->loaded_families & GEXIV2_OPEN_IPTC))
+        family = "IPTC";
+
+    if (family == nullptr)
+        return TRUE;
+
+    g_set_error(error, g_quark_from_string("GExiv2"), 501, "%s metadata was not loaded, cannot access %s", family, tag);
+
     return FALSE;
 }
 
@@ -364,6 +736,7 @@ gboolean gexiv2_metadata_from_app1_segment(GExiv2Metadata* self, const guint8* d
             return FALSE;
 
         Exiv2::ExifParser::decode(priv->image->exifData(), data + offset, n_data - offset);
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         gexiv2_metadata_init_internal(self, error);
         if (error && *error) {
             // Cleanup
@@ -381,7 +754,21 @@ gboolean gexiv2_metadata_from_app1_segment(GExiv2Metadata* self, const guint8* d
     return FALSE;
 }
 
-static gboolean gexiv2_metadata_save_internal (GExiv2Metadata *self, image_ptr image, GError **error) {
+// Families that have to be written when saving to path. The file the metadata was read from
+// already has the families that did not change since.
+static GExiv2OpenFlags gexiv2_metadata_families_to_save(GExiv2MetadataPrivate* priv, const gchar* path) {
+    auto families = priv->loaded_families & (GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP | GEXIV2_OPEN_IPTC | GEXIV2_OPEN_COMMENT);
+
+    if (priv->path != nullptr && g_strcmp0(priv->path, path) == 0)
+        families &= priv->dirty_families;
+
+    return static_cast<GExiv2OpenFlags>(families);
+}
+
+static gboolean gexiv2_metadata_save_internal(GExiv2Metadata* self,
+                                              const image_ptr& image,
+                                              GExiv2OpenFlags families,
+                                              GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
 
@@ -398,8 +785,9 @@ static gboolean gexiv2_metadata_save_internal (GExiv2Metadata *self, image_ptr i
     try {
         image->readMetadata();
 
+        // Families that are not written keep whatever the target already has
         Exiv2::AccessMode mode = image->checkMode(Exiv2::mdExif);
-        if (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite) {
+        if ((families & GEXIV2_OPEN_EXIF) && (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite)) {
             /* For tiff some image data is stored in exif. This should not
                be overwritten. (see libkexiv2/kexiv2.cpp)
              */
@@ -424,110 +812,830 @@ static gboolean gexiv2_metadata_save_internal (GExiv2Metadata *self, image_ptr i
                  new_exif_data["Exif.Image.ResolutionUnit"];
                  */
 
-                image->setExifData(priv->image->exifData());
-            } else {
-                image->setExifData(priv->image->exifData());
-            }
+                image->setExifData(priv->image->exifData());
+            } else {
+                image->setExifData(priv->image->exifData());
+            }
+        }
+
+        mode = image->checkMode(Exiv2::mdXmp);
+        if ((families & GEXIV2_OPEN_XMP) && (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite))
+            image->setXmpData(priv->image->xmpData());
+        else
+            // Copy the packet as it was read instead of serializing it again
+            image->writeXmpFromPacket(true);
+
+        mode = image->checkMode(Exiv2::mdIptc);
+        if ((families & GEXIV2_OPEN_IPTC) && (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite))
+            image->setIptcData(priv->image->iptcData());
+
+        mode = image->checkMode(Exiv2::mdComment);
+        if ((families & GEXIV2_OPEN_COMMENT) && (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite))
+            image->setComment(priv->comment);
+
+        image->writeMetadata();
+
+        return TRUE;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_save_external (GExiv2Metadata *self, const gchar *path, GError **error) {
+    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
+
+    try {
+        GError* inner_error = nullptr;
+
+        auto local_path = convert_path(path, &inner_error);
+        if (inner_error != nullptr) {
+            g_propagate_error(error, inner_error);
+
+            return FALSE;
+        }
+
+        auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+
+        return gexiv2_metadata_save_internal(self,
+                                             Exiv2::ImageFactory::create(Exiv2::ImageType::xmp, local_path),
+                                             priv->loaded_families,
+                                             error);
+    } catch (Exiv2::Error &e) {
+        error << e;
+    }
+    catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+gboolean gexiv2_metadata_save_file (GExiv2Metadata *self, const gchar *path, GError **error) {
+    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
+
+    try {
+        GError* inner_error = nullptr;
+
+        auto local_path = convert_path(path, &inner_error);
+        if (inner_error != nullptr) {
+            g_propagate_error(error, inner_error);
+
+            return FALSE;
+        }
+
+        auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+        auto families = gexiv2_metadata_families_to_save(priv, path);
+
+        // Nothing changed since the file was read or last saved
+        if (families == 0)
+            return TRUE;
+
+        if (!gexiv2_metadata_save_internal(self, Exiv2::ImageFactory::open(local_path), families, error))
+            return FALSE;
+
+        if (g_strcmp0(priv->path, path) == 0)
+            priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
+
+        return TRUE;
+    } catch (Exiv2::Error &e) {
+        error << e;
+    }
+    catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+// Writes the XMP of self over the packet in the file at path, if the file format has no
+// checksums over it and the new packet can be made exactly as long as the old one. Only the
+// JPEG segment headers or the first TIFF IFD and the old packet itself are read. Returns FALSE
+// without setting error if the file has to be rewritten instead.
+static gboolean gexiv2_metadata_patch_xmp(GExiv2Metadata* self, const gchar* path, GError** error) {
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+    goffset offset = 0;
+    std::string contents;
+    {
+        g_autoptr(GFileInputStream) input = g_file_read(file, nullptr, error);
+        if (input == nullptr)
+            return FALSE;
+
+        gsize length = 0;
+        if (!detail::find_xmp_packet(G_INPUT_STREAM(input), nullptr, offset, length, error))
+            return FALSE;
+
+        contents.resize(length);
+        gsize contents_length = 0;
+        if (!g_seekable_seek(G_SEEKABLE(input), offset, G_SEEK_SET, nullptr, error) ||
+            !g_input_stream_read_all(G_INPUT_STREAM(input), &contents[0], length, &contents_length, nullptr, error))
+            return FALSE;
+
+        contents.resize(contents_length);
+    }
+
+    // The space left for the packet to grow is only known if it has a writable trailer
+    auto begin = contents.find("<?xpacket begin=");
+    auto end = std::string::npos;
+    for (const auto* trailer : {"<?xpacket end=\"w\"?>", "<?xpacket end='w'?>"}) {
+        auto found = contents.rfind(trailer);
+        if (found != std::string::npos && begin != std::string::npos && found > begin) {
+            end = found + strlen(trailer);
+            break;
+        }
+    }
+
+    if (end == std::string::npos)
+        return FALSE;
+
+    auto old_length = end - begin;
+    GError* inner_error = nullptr;
+    g_autofree gchar* packet = gexiv2_metadata_generate_xmp_packet(
+        self, static_cast<GExiv2XmpFormatFlags>(GEXIV2_USE_COMPACT_FORMAT | GEXIV2_EXACT_PACKET_LENGTH),
+        static_cast<guint32>(old_length), &inner_error);
+
+    // The XMP toolkit fails if the packet does not fit into the requested length
+    if (packet == nullptr || strlen(packet) != old_length) {
+        g_clear_error(&inner_error);
+
+        return FALSE;
+    }
+
+    g_autoptr(GFileIOStream) stream = g_file_open_readwrite(file, nullptr, error);
+    if (stream == nullptr)
+        return FALSE;
+
+    if (!g_seekable_seek(G_SEEKABLE(stream), offset + static_cast<goffset>(begin), G_SEEK_SET, nullptr, error))
+        return FALSE;
+
+    auto* output = g_io_stream_get_output_stream(G_IO_STREAM(stream));
+    if (!g_output_stream_write_all(output, packet, old_length, nullptr, nullptr, error))
+        return FALSE;
+
+    return g_io_stream_close(G_IO_STREAM(stream), nullptr, error);
+}
+
+gboolean gexiv2_metadata_save_file_in_place(GExiv2Metadata* self,
+                                            const gchar* path,
+                                            GExiv2SaveMethod* method,
+                                            GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    try {
+        GError* inner_error = nullptr;
+
+        auto local_path = convert_path(path, &inner_error);
+        if (inner_error != nullptr) {
+            g_propagate_error(error, inner_error);
+
+            return FALSE;
+        }
+
+        auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+        auto families = gexiv2_metadata_families_to_save(priv, path);
+        auto used = GEXIV2_SAVE_METHOD_NONE;
+
+        if (families == GEXIV2_OPEN_XMP) {
+            if (gexiv2_metadata_patch_xmp(self, path, &inner_error))
+                used = GEXIV2_SAVE_METHOD_IN_PLACE;
+
+            if (inner_error != nullptr) {
+                g_propagate_error(error, inner_error);
+
+                return FALSE;
+            }
+        }
+
+        if (families != 0 && used == GEXIV2_SAVE_METHOD_NONE) {
+            if (!gexiv2_metadata_save_internal(self, Exiv2::ImageFactory::open(local_path), families, error))
+                return FALSE;
+
+            used = GEXIV2_SAVE_METHOD_REWRITE;
+        }
+
+        if (g_strcmp0(priv->path, path) == 0)
+            priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
+
+        if (method != nullptr)
+            *method = used;
+
+        return TRUE;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+static void set_error_from_errno(GError** error, int saved_errno, const gchar* what, const gchar* path) {
+    g_set_error(error, G_IO_ERROR, g_io_error_from_errno(saved_errno), "Failed to %s %s: %s", what, path,
+                g_strerror(saved_errno));
+}
+
+// Flushes fd to disk as far as flags ask for
+static gboolean sync_fd(int fd, GExiv2SaveFlags flags, const gchar* path, GError** error) {
+    int result = 0;
+
+    if (flags & GEXIV2_SAVE_FULL_SYNC) {
+#if defined(G_OS_WIN32)
+        result = _commit(fd);
+#elif defined(F_FULLFSYNC)
+        // fsync() does not flush the drive cache on macOS
+        result = fcntl(fd, F_FULLFSYNC);
+        if (result != 0)
+            result = fsync(fd);
+#else
+        result = fsync(fd);
+#endif
+    } else if (flags & GEXIV2_SAVE_DATA_SYNC) {
+#if defined(G_OS_WIN32)
+        result = _commit(fd);
+#elif defined(HAVE_FDATASYNC)
+        result = fdatasync(fd);
+#else
+        result = fsync(fd);
+#endif
+    }
+
+    if (result != 0) {
+        set_error_from_errno(error, errno, "sync", path);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean write_fd(int fd, const guint8* data, gsize size, const gchar* path, GError** error) {
+    while (size > 0) {
+        auto written = write(fd, data, MIN(size, static_cast<gsize>(G_MAXINT)));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+
+            set_error_from_errno(error, errno, "write", path);
+
+            return FALSE;
+        }
+
+        data += written;
+        size -= static_cast<gsize>(written);
+    }
+
+    return TRUE;
+}
+
+// Makes the rename of a file in the directory of path durable
+static gboolean sync_parent_directory(const gchar* path, GError** error) {
+#ifdef G_OS_UNIX
+    g_autofree gchar* directory = g_path_get_dirname(path);
+    int fd = g_open(directory, O_RDONLY, 0);
+    if (fd < 0) {
+        set_error_from_errno(error, errno, "open", directory);
+
+        return FALSE;
+    }
+
+    // Some file systems do not support syncing directories, there is nothing to do then
+    if (fsync(fd) != 0 && errno != EINVAL && errno != ENOTSUP) {
+        set_error_from_errno(error, errno, "sync", directory);
+        close(fd);
+
+        return FALSE;
+    }
+
+    return g_close(fd, error);
+#else
+    return TRUE;
+#endif
+}
+
+static gboolean write_file_with_flags(const gchar* path,
+                                      const guint8* data,
+                                      gsize size,
+                                      GExiv2SaveFlags flags,
+                                      GError** error) {
+    const bool atomic = (flags & GEXIV2_SAVE_ATOMIC_RENAME) != 0;
+    g_autofree gchar* target_path = g_strdup(path);
+    g_autofree gchar* temp_path = nullptr;
+    int fd = -1;
+
+    if (atomic) {
+#ifdef G_OS_UNIX
+        // Replace the file a symbolic link points to rather than the link itself
+        char* resolved = realpath(path, nullptr);
+        if (resolved != nullptr) {
+            g_free(target_path);
+            target_path = g_strdup(resolved);
+            free(resolved);
+        }
+#endif
+
+        // The temporary file has to be on the same file system for the rename to be atomic
+        temp_path = g_strconcat(target_path, ".XXXXXX", nullptr);
+        fd = g_mkstemp_full(temp_path, O_RDWR | O_BINARY, 0666);
+        if (fd < 0) {
+            set_error_from_errno(error, errno, "create", temp_path);
+
+            return FALSE;
+        }
+
+#ifdef G_OS_UNIX
+        // Keep the owner and permissions of the file that is replaced. Only privileged processes
+        // can give a file away, so the owner is kept where possible and otherwise just the group.
+        // The mode comes last as changing the owner clears the set-user-ID and set-group-ID bits
+        GStatBuf info;
+        if (g_stat(target_path, &info) == 0) {
+            if (fchown(fd, info.st_uid, info.st_gid) != 0 && fchown(fd, static_cast<uid_t>(-1), info.st_gid) != 0)
+                g_debug("Failed to keep the owner of %s: %s", target_path, g_strerror(errno));
+
+            if (fchmod(fd, info.st_mode & 07777) != 0) {
+                set_error_from_errno(error, errno, "chmod", temp_path);
+                close(fd);
+                g_unlink(temp_path);
+
+                return FALSE;
+            }
+        }
+#endif
+    } else {
+        fd = g_open(path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+        if (fd < 0) {
+            set_error_from_errno(error, errno, "open", path);
+
+            return FALSE;
+        }
+    }
+
+    const gchar* written_path = atomic ? temp_path : path;
+    if (!write_fd(fd, data, size, written_path, error) || !sync_fd(fd, flags, written_path, error)) {
+        close(fd);
+        if (atomic)
+            g_unlink(temp_path);
+
+        return FALSE;
+    }
+
+    if (!g_close(fd, error)) {
+        if (atomic)
+            g_unlink(temp_path);
+
+        return FALSE;
+    }
+
+    if (!atomic)
+        return TRUE;
+
+    if (g_rename(temp_path, target_path) != 0) {
+        set_error_from_errno(error, errno, "replace", target_path);
+        g_unlink(temp_path);
+
+        return FALSE;
+    }
+
+    if (flags & GEXIV2_SAVE_FULL_SYNC)
+        return sync_parent_directory(target_path, error);
+
+    return TRUE;
+}
+
+gboolean gexiv2_metadata_save_file_with_flags(GExiv2Metadata* self,
+                                              const gchar* path,
+                                              GExiv2SaveFlags flags,
+                                              GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+
+    auto families = gexiv2_metadata_families_to_save(priv, path);
+
+    // Nothing changed since the file was read or last saved
+    if (families == 0)
+        return TRUE;
+
+    GError* inner_error = nullptr;
+    auto local_path = convert_path(path, &inner_error);
+    if (inner_error != nullptr) {
+        g_propagate_error(error, inner_error);
+
+        return FALSE;
+    }
+
+    try {
+        // The original is mapped rather than read, and the new contents are built in memory
+        Exiv2::FileIo original(local_path);
+        if (original.open() != 0)
+            throw Exiv2::Error(Exiv2::ErrorCode::kerDataSourceOpenFailed, original.path(), Exiv2::strError());
+
+        auto image = Exiv2::ImageFactory::open(original.mmap(), original.size());
+        if (!gexiv2_metadata_save_internal(self, image, families, error))
+            return FALSE;
+
+        // The new contents are a copy by now. The original has to be unmapped before it is
+        // truncated, touching a mapping past the end of its file is fatal
+        original.munmap();
+        original.close();
+
+        auto& io = image->io();
+        auto* data = reinterpret_cast<const guint8*>(io.mmap());
+        auto result = write_file_with_flags(path, data, io.size(), flags, error);
+        io.munmap();
+
+        if (result && g_strcmp0(priv->path, path) == 0)
+            priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
+
+        return result;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return FALSE;
+}
+
+// Size of the blocks the asynchronous save writes out between progress reports
+// and cancellation checks
+constexpr gsize SAVE_BLOCK_SIZE = 256 * 1024;
+
+static gboolean write_data_to_file(GFile* file,
+                                   const guint8* data,
+                                   gsize size,
+                                   GFileProgressCallback progress_callback,
+                                   gpointer progress_callback_data,
+                                   GCancellable* cancellable,
+                                   GError** error) {
+    g_autoptr(GFileOutputStream) stream =
+        g_file_replace(file, nullptr, FALSE, G_FILE_CREATE_NONE, cancellable, error);
+    if (stream == nullptr)
+        return FALSE;
+
+    gsize written = 0;
+    while (written < size) {
+        gsize block_written = 0;
+        if (!g_output_stream_write_all(G_OUTPUT_STREAM(stream),
+                                       data + written,
+                                       MIN(size - written, SAVE_BLOCK_SIZE),
+                                       &block_written,
+                                       cancellable,
+                                       error)) {
+            // Closing a replace stream with a cancelled cancellable drops the
+            // temporary file and leaves the original untouched
+            g_autoptr(GCancellable) abort = g_cancellable_new();
+            g_cancellable_cancel(abort);
+            g_output_stream_close(G_OUTPUT_STREAM(stream), abort, nullptr);
+
+            return FALSE;
+        }
+
+        written += block_written;
+        if (progress_callback != nullptr)
+            progress_callback(static_cast<goffset>(written), static_cast<goffset>(size), progress_callback_data);
+    }
+
+    return g_output_stream_close(G_OUTPUT_STREAM(stream), cancellable, error);
+}
+
+// Variant of gexiv2_metadata_save_file/_external that renders the new file in memory first
+// and then writes it out block-wise, which allows for progress reports and cancellation
+static gboolean gexiv2_metadata_save_with_progress_internal(GExiv2Metadata* self,
+                                                            const gchar* path,
+                                                            gboolean sidecar,
+                                                            GFileProgressCallback progress_callback,
+                                                            gpointer progress_callback_data,
+                                                            GCancellable* cancellable,
+                                                            GError** error) {
+    g_autoptr(GMappedFile) mapped = nullptr;
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    auto families = sidecar ? priv->loaded_families : gexiv2_metadata_families_to_save(priv, path);
+
+    // Nothing changed since the file was read or last saved
+    if (!sidecar && families == 0)
+        return TRUE;
+
+    try {
+        image_ptr image;
+
+        if (sidecar) {
+            image = Exiv2::ImageFactory::create(Exiv2::ImageType::xmp);
+        } else {
+            mapped = g_mapped_file_new(path, FALSE, error);
+            if (mapped == nullptr)
+                return FALSE;
+
+            image = Exiv2::ImageFactory::open(reinterpret_cast<const Exiv2::byte*>(g_mapped_file_get_contents(mapped)),
+                                              g_mapped_file_get_length(mapped));
         }
 
-        mode = image->checkMode(Exiv2::mdXmp);
-        if (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite)
-            image->setXmpData(priv->image->xmpData());
+        if (!gexiv2_metadata_save_internal(self, image, families, error))
+            return FALSE;
 
-        mode = image->checkMode(Exiv2::mdIptc);
-        if (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite)
-            image->setIptcData(priv->image->iptcData());
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+            return FALSE;
 
-        mode = image->checkMode(Exiv2::mdComment);
-        if (mode == Exiv2::amWrite || mode == Exiv2::amReadWrite)
-            image->setComment(priv->comment);
+        g_autoptr(GFile) file = g_file_new_for_path(path);
+        auto& io = image->io();
+        auto* data = reinterpret_cast<const guint8*>(io.mmap());
+        auto result = write_data_to_file(file,
+                                         data,
+                                         io.size(),
+                                         progress_callback,
+                                         progress_callback_data,
+                                         cancellable,
+                                         error);
+        io.munmap();
 
-        image->writeMetadata();
+        if (result && !sidecar && g_strcmp0(priv->path, path) == 0)
+            priv->dirty_families = static_cast<GExiv2OpenFlags>(0);
 
-        return TRUE;
+        return result;
     } catch (Exiv2::Error& e) {
         error << e;
     } catch (std::exception& e) {
         error << e;
     }
+
     return FALSE;
 }
 
-gboolean gexiv2_metadata_save_external (GExiv2Metadata *self, const gchar *path, GError **error) {
-    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
+struct SaveTaskData {
+    gchar* path;
+    gboolean sidecar;
+    GFileProgressCallback progress_callback;
+    gpointer progress_callback_data;
+    GMainContext* context;
+};
 
-    try {
-        GError* inner_error = nullptr;
+static void save_task_data_free(gpointer data) {
+    auto* task_data = static_cast<SaveTaskData*>(data);
 
-        auto local_path = convert_path(path, &inner_error);
-        if (inner_error != nullptr) {
-            g_propagate_error(error, inner_error);
+    g_free(task_data->path);
+    g_main_context_unref(task_data->context);
+    g_free(task_data);
+}
 
-            return FALSE;
-        }
+struct SaveProgress {
+    GFileProgressCallback callback;
+    gpointer user_data;
+    goffset current;
+    goffset total;
+};
 
-        return gexiv2_metadata_save_internal(self,
-                                             Exiv2::ImageFactory::create(Exiv2::ImageType::xmp, local_path),
-                                             error);
-    } catch (Exiv2::Error &e) {
-        error << e;
-    }
-    catch (std::exception& e) {
-        error << e;
-    }
+static gboolean save_progress_dispatch(gpointer data) {
+    auto* progress = static_cast<SaveProgress*>(data);
 
-    return FALSE;
+    progress->callback(progress->current, progress->total, progress->user_data);
+
+    return G_SOURCE_REMOVE;
 }
 
-gboolean gexiv2_metadata_save_file (GExiv2Metadata *self, const gchar *path, GError **error) {
-    g_return_val_if_fail (GEXIV2_IS_METADATA (self), FALSE);
+// Runs in the worker thread, forwards the progress to the context the task was started in
+static void save_progress_forward(goffset current, goffset total, gpointer user_data) {
+    auto* task_data = static_cast<SaveTaskData*>(user_data);
+    auto* progress = g_new(SaveProgress, 1);
+
+    progress->callback = task_data->progress_callback;
+    progress->user_data = task_data->progress_callback_data;
+    progress->current = current;
+    progress->total = total;
+
+    g_main_context_invoke_full(task_data->context, G_PRIORITY_DEFAULT, save_progress_dispatch, progress, g_free);
+}
+
+static void gexiv2_metadata_save_thread(GTask* task,
+                                        gpointer source_object,
+                                        gpointer task_data,
+                                        GCancellable* cancellable) {
+    auto* self = GEXIV2_METADATA(source_object);
+    auto* data = static_cast<SaveTaskData*>(task_data);
+    GError* error = nullptr;
+
+    if (g_task_return_error_if_cancelled(task))
+        return;
+
+    if (gexiv2_metadata_save_with_progress_internal(self,
+                                                    data->path,
+                                                    data->sidecar,
+                                                    data->progress_callback != nullptr ? save_progress_forward : nullptr,
+                                                    data,
+                                                    cancellable,
+                                                    &error))
+        g_task_return_boolean(task, TRUE);
+    else if (error != nullptr)
+        g_task_return_error(task, error);
+    else
+        g_task_return_new_error(task, g_quark_from_string("GExiv2"), 501, "Failed to save %s", data->path);
+}
+
+static void gexiv2_metadata_save_async_internal(GExiv2Metadata* self,
+                                                const gchar* path,
+                                                gboolean sidecar,
+                                                GFileProgressCallback progress_callback,
+                                                gpointer progress_callback_data,
+                                                GCancellable* cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer user_data,
+                                                gpointer source_tag) {
+    auto* data = g_new0(SaveTaskData, 1);
+    data->path = g_strdup(path);
+    data->sidecar = sidecar;
+    data->progress_callback = progress_callback;
+    data->progress_callback_data = progress_callback_data;
+    data->context = g_main_context_ref_thread_default();
+
+    GTask* task = g_task_new(self, cancellable, callback, user_data);
+    g_task_set_source_tag(task, source_tag);
+    g_task_set_task_data(task, data, save_task_data_free);
+    g_task_run_in_thread(task, gexiv2_metadata_save_thread);
+    g_object_unref(task);
+}
+
+void gexiv2_metadata_save_file_async(GExiv2Metadata* self,
+                                     const gchar* path,
+                                     GFileProgressCallback progress_callback,
+                                     gpointer progress_callback_data,
+                                     GCancellable* cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data) {
+    g_return_if_fail(GEXIV2_IS_METADATA(self));
+    g_return_if_fail(path != nullptr);
+    g_return_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable));
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    g_return_if_fail(priv->image.get() != nullptr);
+
+    gexiv2_metadata_save_async_internal(self,
+                                        path,
+                                        FALSE,
+                                        progress_callback,
+                                        progress_callback_data,
+                                        cancellable,
+                                        callback,
+                                        user_data,
+                                        reinterpret_cast<gpointer>(gexiv2_metadata_save_file_async));
+}
+
+gboolean gexiv2_metadata_save_file_finish(GExiv2Metadata* self, GAsyncResult* result, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+void gexiv2_metadata_save_external_async(GExiv2Metadata* self,
+                                         const gchar* path,
+                                         GFileProgressCallback progress_callback,
+                                         gpointer progress_callback_data,
+                                         GCancellable* cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data) {
+    g_return_if_fail(GEXIV2_IS_METADATA(self));
+    g_return_if_fail(path != nullptr);
+    g_return_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable));
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    g_return_if_fail(priv->image.get() != nullptr);
+
+    gexiv2_metadata_save_async_internal(self,
+                                        path,
+                                        TRUE,
+                                        progress_callback,
+                                        progress_callback_data,
+                                        cancellable,
+                                        callback,
+                                        user_data,
+                                        reinterpret_cast<gpointer>(gexiv2_metadata_save_external_async));
+}
+
+gboolean gexiv2_metadata_save_external_finish(GExiv2Metadata* self, GAsyncResult* result, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
+gboolean gexiv2_metadata_save_to_stream(GExiv2Metadata* self,
+                                        GOutputStream* stream,
+                                        GCancellable* cancellable,
+                                        GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(G_IS_OUTPUT_STREAM(stream), FALSE);
+    g_return_val_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+    auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+
+    if (priv->metadata_only) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                            "Image data was not loaded, the original file contents need to be passed");
+
+        return FALSE;
+    }
+
+    auto& internal_io = priv->image->io();
+    Exiv2::byte* data = nullptr;
+    gboolean result = FALSE;
 
     try {
-        GError* inner_error = nullptr;
+        data = internal_io.mmap();
 
-        auto local_path = convert_path(path, &inner_error);
-        if (inner_error != nullptr) {
-            g_propagate_error(error, inner_error);
+        // The original stays mapped until the new file is written, as the image reads from it
+        auto* output = new GExiv2::GioOutputIo(data, internal_io.size(), stream, cancellable);
+        auto image = Exiv2::ImageFactory::open(Exiv2::BasicIo::UniquePtr(output));
 
-            return FALSE;
+        GError* inner_error = nullptr;
+        result = gexiv2_metadata_save_internal(self, image, priv->loaded_families, &inner_error);
+
+        // Report why the stream failed rather than Exiv2's generic write error
+        if (!result && output->stream_error() != nullptr) {
+            g_clear_error(&inner_error);
+            inner_error = g_error_copy(output->stream_error());
         }
 
-        return gexiv2_metadata_save_internal(self, Exiv2::ImageFactory::open(local_path), error);
-    } catch (Exiv2::Error &e) {
+        if (inner_error != nullptr)
+            g_propagate_error(error, inner_error);
+    } catch (Exiv2::Error& e) {
         error << e;
-    }
-    catch (std::exception& e) {
+    } catch (std::exception& e) {
         error << e;
     }
 
-    return FALSE;
+    if (data != nullptr)
+        internal_io.munmap();
+
+    return result;
+}
+
+// Frees the image whose io holds the data of a GBytes returned by gexiv2_metadata_as_bytes()
+static void gexiv2_metadata_as_bytes_free(gpointer data) {
+    delete static_cast<Exiv2::Image*>(data);
 }
 
 GBytes* gexiv2_metadata_as_bytes(GExiv2Metadata* self, GBytes* bytes, GError** error) {
     g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
     auto* priv = (GExiv2MetadataPrivate*) gexiv2_metadata_get_instance_private(self);
 
+    if (bytes == nullptr && priv->metadata_only) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                            "Image data was not loaded, the original file contents need to be passed");
+
+        return nullptr;
+    }
+
+    auto& internal_io = priv->image->io();
+    Exiv2::byte* mapped = nullptr;
+
     try {
+        // Neither source is copied, MemIo only reads from the memory it is given. The internal
+        // image has to stay mapped until the new file is written for that
         image_ptr image;
+        const Exiv2::byte* source = nullptr;
         if (bytes == nullptr) {
-            auto& internalIo = priv->image->io();
-            auto data = internalIo.mmap();
-            auto memIo = GExiv2::GioIo::ptr_type(new Exiv2::MemIo(data, internalIo.size()));
-            internalIo.munmap();
-            image = Exiv2::ImageFactory::open(std::move(memIo));
+            mapped = internal_io.mmap();
+            source = mapped;
+            image = Exiv2::ImageFactory::open(Exiv2::BasicIo::UniquePtr(new Exiv2::MemIo(mapped, internal_io.size())));
         } else {
             gsize size{0};
-            auto* data = g_bytes_get_data(bytes, &size);
-            image = Exiv2::ImageFactory::open(static_cast<const Exiv2::byte*>(data),
-                                              static_cast<GExiv2::GioIo::size_type>(size));
+            source = static_cast<const Exiv2::byte*>(g_bytes_get_data(bytes, &size));
+            image = Exiv2::ImageFactory::open(source, static_cast<size_t>(size));
+        }
+
+        if (!gexiv2_metadata_save_internal(self, image, priv->loaded_families, error)) {
+            if (mapped != nullptr)
+                internal_io.munmap();
+
+            return nullptr;
         }
 
         auto& io = image->io();
-        gexiv2_metadata_save_internal(self, std::move(image), error);
-        auto* data = reinterpret_cast<char*>(io.mmap());
+        auto* data = io.mmap();
         auto size = static_cast<gsize>(io.size());
-        auto* result = g_bytes_new(data, size);
-        io.munmap();
+        GBytes* result = nullptr;
+
+        if (data == source) {
+            // Nothing was written, so image still reads from the source
+            result = bytes != nullptr ? g_bytes_ref(bytes) : g_bytes_new(data, size);
+        } else {
+            // Exiv2 moved the new file into the io of image, so the result takes over image
+            // instead of copying the file out of it
+            image->clearMetadata();
+            result = g_bytes_new_with_free_func(data, size, gexiv2_metadata_as_bytes_free, image.release());
+        }
+
+        if (mapped != nullptr)
+            internal_io.munmap();
 
         return result;
     } catch (Exiv2::Error& e) {
@@ -536,6 +1644,9 @@ GBytes* gexiv2_metadata_as_bytes(GExiv2Metadata* self, GBytes* bytes, GError** e
         error << e;
     }
 
+    if (mapped != nullptr)
+        internal_io.munmap();
+
     return nullptr;
 }
 
@@ -550,6 +1661,9 @@ gboolean gexiv2_metadata_has_tag(GExiv2Metadata* self, const gchar* tag, GError*
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return FALSE;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_has_xmp_tag(self, tag);
 
@@ -576,6 +1690,9 @@ gboolean gexiv2_metadata_clear_tag(GExiv2Metadata* self, const gchar* tag, GErro
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return FALSE;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_clear_xmp_tag(self, tag);
 
@@ -605,6 +1722,7 @@ void gexiv2_metadata_clear (GExiv2Metadata *self) {
     gexiv2_metadata_clear_comment (self);
 
     priv->image->clearMetadata();
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_ALL);
 }
 
 const gchar* gexiv2_metadata_get_mime_type (GExiv2Metadata *self) {
@@ -735,6 +1853,7 @@ void gexiv2_metadata_set_orientation(GExiv2Metadata* self, GExiv2Orientation ori
         Exiv2::ExifData& exif_data = priv->image->exifData();
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+        gexiv2_metadata_tags_changed(priv, static_cast<GExiv2OpenFlags>(GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP));
         exif_data["Exif.Image.Orientation"] = static_cast<uint16_t>(orientation);
         xmp_data["Xmp.tiff.Orientation"] = static_cast<uint16_t>(orientation);
 
@@ -842,6 +1961,7 @@ void gexiv2_metadata_set_metadata_pixel_width(GExiv2Metadata* self, gint width,
         Exiv2::ExifData& exif_data = priv->image->exifData();
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+        gexiv2_metadata_tags_changed(priv, static_cast<GExiv2OpenFlags>(GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP));
         exif_data["Exif.Photo.PixelXDimension"] = static_cast<uint32_t>(width);
         exif_data["Exif.Image.ImageWidth"] = static_cast<uint32_t>(width);
         xmp_data["Xmp.tiff.ImageWidth"] = static_cast<uint32_t>(width);
@@ -868,6 +1988,7 @@ void gexiv2_metadata_set_metadata_pixel_height(GExiv2Metadata* self, gint height
         Exiv2::ExifData& exif_data = priv->image->exifData();
         Exiv2::XmpData& xmp_data = priv->image->xmpData();
 
+        gexiv2_metadata_tags_changed(priv, static_cast<GExiv2OpenFlags>(GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP));
         exif_data["Exif.Photo.PixelYDimension"] = static_cast<uint32_t>(height);
         exif_data["Exif.Image.ImageLength"] = static_cast<uint32_t>(height);
         xmp_data["Xmp.tiff.ImageLength"] = static_cast<uint32_t>(height);
@@ -976,6 +2097,8 @@ void gexiv2_metadata_set_comment(GExiv2Metadata* self, const gchar* comment, GEr
 
         gexiv2_metadata_set_comment_internal(self, comment);
 
+        gexiv2_metadata_tags_changed(priv, static_cast<GExiv2OpenFlags>(GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP |
+                                                                        GEXIV2_OPEN_IPTC | GEXIV2_OPEN_COMMENT));
         exif_data["Exif.Image.ImageDescription"] = comment;
         exif_data["Exif.Photo.UserComment"] = comment;
         exif_data["Exif.Image.XPComment"] = comment;
@@ -998,6 +2121,7 @@ void gexiv2_metadata_clear_comment (GExiv2Metadata *self) {
 
     /* don't delete the comment field, merely empty it */
     gexiv2_metadata_set_comment_internal (self, "");
+    gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_COMMENT);
 }
 
 gboolean gexiv2_metadata_is_exif_tag(const gchar* tag) {
@@ -1026,6 +2150,9 @@ gchar* gexiv2_metadata_get_tag_string (GExiv2Metadata *self, const gchar* tag, G
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return nullptr;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_get_xmp_tag_string (self, tag, error);
 
@@ -1049,6 +2176,9 @@ gboolean gexiv2_metadata_set_tag_string (GExiv2Metadata *self, const gchar* tag,
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return FALSE;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_set_xmp_tag_string(self, tag, value, error);
 
@@ -1064,6 +2194,227 @@ gboolean gexiv2_metadata_set_tag_string (GExiv2Metadata *self, const gchar* tag,
     return FALSE;
 }
 
+bool detail::resolve_tags(const gchar* const* tags, TagRequest& request, GError** error) {
+    for (auto tag = tags; *tag != nullptr; tag++) {
+        auto id = detail::parse_tag_id(*tag, error);
+        if (!id)
+            return false;
+
+        // Later names with the same key join the group of the first one
+        auto next = request.groups.size();
+        size_t group = 0;
+        if (id->family == GEXIV2_OPEN_EXIF) {
+            const auto& key = static_cast<const Exiv2::ExifKey&>(*id->key);
+            auto numeric = detail::numeric_key(static_cast<guint32>(key.ifdId()), key.tag());
+            group = request.exif.emplace(numeric, next).first->second;
+        } else if (id->family == GEXIV2_OPEN_IPTC) {
+            const auto& key = static_cast<const Exiv2::IptcKey&>(*id->key);
+            group = request.iptc.emplace(detail::numeric_key(key.record(), key.tag()), next).first->second;
+        } else {
+            group = request.xmp.emplace(id->key->key(), next).first->second;
+        }
+
+        if (group == next)
+            request.groups.emplace_back();
+
+        request.groups[group].push_back(request.names.size());
+        request.names.emplace_back(*tag);
+    }
+
+    return true;
+}
+
+GHashTable* detail::get_tags_batch(GExiv2Metadata* self, const TagRequest& request, GError** error) {
+    auto* priv = gexiv2_priv(self);
+
+    for (const auto& name : request.names) {
+        if (!gexiv2_metadata_check_family_loaded(self, name.c_str(), error))
+            return nullptr;
+    }
+
+    GHashTable* values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    std::vector<bool> found(request.groups.size());
+    auto add_values = [&request, &found, values](size_t group, const std::string& value) {
+        found[group] = true;
+        for (auto index : request.groups[group])
+            g_hash_table_insert(values, g_strdup(request.names[index].c_str()), g_strdup(value.c_str()));
+    };
+
+    try {
+        // As in gexiv2_metadata_get_tag_string(), the first entry with a value wins
+        auto remaining = request.exif.size();
+        for (const auto& datum : priv->image->exifData()) {
+            if (remaining == 0)
+                break;
+            if (datum.count() == 0)
+                continue;
+
+            auto it = request.exif.find(detail::numeric_key(static_cast<guint32>(datum.ifdId()), datum.tag()));
+            if (it != request.exif.end() && !found[it->second]) {
+                add_values(it->second, datum.toString());
+                remaining--;
+            }
+        }
+
+        remaining = request.xmp.size();
+        for (const auto& datum : priv->image->xmpData()) {
+            if (remaining == 0)
+                break;
+            if (datum.count() == 0)
+                continue;
+
+            auto it = request.xmp.find(datum.key());
+            if (it != request.xmp.end() && !found[it->second]) {
+                add_values(it->second, datum.toString());
+                remaining--;
+            }
+        }
+
+        // Repeatable IPTC tags exist as separate entries, their values are joined
+        std::unordered_map<size_t, std::string> iptc_values;
+        remaining = request.iptc.size();
+        for (const auto& datum : priv->image->iptcData()) {
+            if (remaining == 0)
+                break;
+
+            auto it = request.iptc.find(detail::numeric_key(datum.record(), datum.tag()));
+            if (it == request.iptc.end() || found[it->second])
+                continue;
+
+            auto value = iptc_values.find(it->second);
+            if (value != iptc_values.end()) {
+                value->second.append(", ").append(datum.toString());
+            } else if (datum.count() > 0) {
+                if (Exiv2::IptcDataSets::dataSetRepeatable(datum.tag(), datum.record())) {
+                    iptc_values.emplace(it->second, datum.toString());
+                } else {
+                    add_values(it->second, datum.toString());
+                    remaining--;
+                }
+            }
+        }
+
+        for (const auto& value : iptc_values)
+            add_values(value.first, value.second);
+
+        return values;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    g_hash_table_unref(values);
+
+    return nullptr;
+}
+
+GHashTable* gexiv2_metadata_get_tags_batch(GExiv2Metadata* self, const gchar* const* tags, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
+    g_return_val_if_fail(tags != nullptr, nullptr);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    detail::TagRequest request;
+    if (!detail::resolve_tags(tags, request, error))
+        return nullptr;
+
+    return detail::get_tags_batch(self, request, error);
+}
+
+// GVariant strings must be valid UTF-8 without embedded NULs
+static void gexiv2_metadata_make_valid_utf8(std::string& str) {
+    const gchar* end = nullptr;
+    gsize offset = 0;
+
+    while (!g_utf8_validate(str.data() + offset, str.size() - offset, &end)) {
+        offset = end - str.data();
+        str[offset++] = '?';
+    }
+}
+
+template<typename Container, typename Interpret>
+static void gexiv2_metadata_add_snapshot_entries(GVariantBuilder* builder,
+                                                 const Container& container,
+                                                 std::vector<Exiv2::byte>& buffer,
+                                                 Interpret interpret) {
+    for (const auto& datum : container) {
+        if (datum.count() == 0)
+            continue;
+
+        buffer.resize(datum.size());
+        if (!buffer.empty())
+            datum.copy(buffer.data(), Exiv2::invalidByteOrder);
+
+        std::string interpreted = interpret(datum);
+        gexiv2_metadata_make_valid_utf8(interpreted);
+
+        g_variant_builder_add(builder, "(sq@ays)", datum.key().c_str(), static_cast<guint16>(datum.typeId()),
+                              g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, buffer.data(), buffer.size(), 1),
+                              interpreted.c_str());
+    }
+}
+
+GVariant* gexiv2_metadata_get_snapshot(GExiv2Metadata* self, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a(sqays)"));
+
+    try {
+        std::vector<Exiv2::byte> buffer;
+        const auto& exif_data = priv->image->exifData();
+
+        // Same as the interpreted strings of the single tag getters
+        auto interpret_exif = [&exif_data](const Exiv2::Exifdatum& datum) {
+            std::ostringstream os;
+            auto value = datum.getValue();
+            const auto* comment_value = dynamic_cast<const Exiv2::CommentValue*>(value.get());
+            if (comment_value == nullptr) {
+                datum.write(os, &exif_data);
+            } else {
+                os << comment_value->comment();
+            }
+
+            return os.str();
+        };
+        auto interpret = [](const Exiv2::Metadatum& datum) {
+            std::ostringstream os;
+            datum.write(os);
+            return os.str();
+        };
+
+        gexiv2_metadata_add_snapshot_entries(&builder, exif_data, buffer, interpret_exif);
+        gexiv2_metadata_add_snapshot_entries(&builder, priv->image->xmpData(), buffer, interpret);
+        gexiv2_metadata_add_snapshot_entries(&builder, priv->image->iptcData(), buffer, interpret);
+
+        return g_variant_ref_sink(g_variant_builder_end(&builder));
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    g_variant_builder_clear(&builder);
+
+    return nullptr;
+}
+
+GExiv2TagIter* gexiv2_metadata_iter_tags(GExiv2Metadata* self, GExiv2OpenFlags families, gboolean sorted) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
+
+    return gexiv2_tag_iter_new(self, families, sorted);
+}
+
 gchar* gexiv2_metadata_try_get_tag_string (GExiv2Metadata *self, const gchar* tag, GError **error) {
     return gexiv2_metadata_get_tag_string (self, tag, error);
 }
@@ -1080,6 +2431,9 @@ gchar* gexiv2_metadata_get_tag_interpreted_string (GExiv2Metadata *self, const g
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return nullptr;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_get_xmp_tag_interpreted_string(self, tag, error);
 
@@ -1107,6 +2461,9 @@ gchar** gexiv2_metadata_get_tag_multiple(GExiv2Metadata *self, const gchar* tag,
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return nullptr;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_get_xmp_tag_multiple(self, tag, error);
 
@@ -1131,6 +2488,9 @@ gboolean gexiv2_metadata_set_tag_multiple(GExiv2Metadata *self, const gchar* tag
     g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return FALSE;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_set_xmp_tag_multiple(self, tag, values, error);
 
@@ -1162,6 +2522,9 @@ glong gexiv2_metadata_get_tag_long(GExiv2Metadata *self, const gchar* tag, GErro
     g_return_val_if_fail(priv->image.get() != nullptr, 0);
     g_return_val_if_fail(error == nullptr || *error == nullptr, 0);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return 0;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_get_xmp_tag_long(self, tag, error);
 
@@ -1186,6 +2549,9 @@ gboolean gexiv2_metadata_set_tag_long(GExiv2Metadata *self, const gchar* tag, gl
     g_return_val_if_fail(priv->image.get() != nullptr, 0);
     g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return FALSE;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_set_xmp_tag_long(self, tag, value, error);
 
@@ -1259,6 +2625,12 @@ GExiv2PreviewProperties** gexiv2_metadata_get_preview_properties (GExiv2Metadata
     g_return_val_if_fail(priv != nullptr, nullptr);
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
 
+    GError* error = nullptr;
+    if (!gexiv2_metadata_ensure_previews(self, &error) && error != nullptr) {
+        g_warning("Failed to read preview properties: %s", error->message);
+        g_error_free(error);
+    }
+
     return priv->preview_properties;
 }
 
@@ -1279,6 +2651,13 @@ GExiv2PreviewImage* gexiv2_metadata_get_preview_image(GExiv2Metadata* self,
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
+    if (!gexiv2_metadata_ensure_previews(self, error)) {
+        if (error != nullptr && *error == nullptr)
+            g_set_error_literal(error, g_quark_from_string("GExiv2"), 501, "Previews are not available");
+
+        return nullptr;
+    }
+
     auto* impl = gexiv2_preview_properties_get_impl(props);
     return gexiv2_preview_image_new(priv->preview_manager, *impl, error);
 }
@@ -1309,6 +2688,7 @@ gboolean gexiv2_metadata_set_exif_thumbnail_from_file(GExiv2Metadata* self, cons
 
     try {
         Exiv2::ExifThumb thumb = Exiv2::ExifThumb(priv->image->exifData());
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         thumb.setJpegThumbnail(std::string(path));
 
         return TRUE;
@@ -1343,6 +2723,7 @@ void gexiv2_metadata_set_exif_thumbnail_from_buffer(GExiv2Metadata* self,
 
     try {
         Exiv2::ExifThumb thumb = Exiv2::ExifThumb(priv->image->exifData());
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         thumb.setJpegThumbnail(buffer, size);
     } catch (Exiv2::Error& e) {
         error << e;
@@ -1364,6 +2745,7 @@ void gexiv2_metadata_erase_exif_thumbnail(GExiv2Metadata* self, GError** error)
 
     try {
         Exiv2::ExifThumb thumb = Exiv2::ExifThumb(priv->image->exifData());
+        gexiv2_metadata_tags_changed(priv, GEXIV2_OPEN_EXIF);
         thumb.erase();
     } catch (Exiv2::Error& e) {
         error << e;
@@ -1481,6 +2863,9 @@ GBytes* gexiv2_metadata_get_tag_raw(GExiv2Metadata *self, const gchar* tag, GErr
     g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
+    if (!gexiv2_metadata_check_family_loaded(self, tag, error))
+        return nullptr;
+
     if (gexiv2_metadata_is_xmp_tag(tag))
         return gexiv2_metadata_get_xmp_tag_raw(self, tag, error);
 
@@ -1501,4 +2886,103 @@ GBytes* gexiv2_metadata_try_get_tag_raw(GExiv2Metadata *self, const gchar* tag,
     return  gexiv2_metadata_get_tag_raw(self, tag, error);
 }
 
+gboolean gexiv2_metadata_has_tag_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(id != nullptr, FALSE);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    if (!gexiv2_metadata_check_family_loaded(self, id->name.c_str(), error))
+        return FALSE;
+
+    switch (id->family) {
+        case GEXIV2_OPEN_EXIF:
+            return priv->tag_index->contains(GEXIV2_OPEN_EXIF, priv->image->exifData(), id->name.c_str());
+        case GEXIV2_OPEN_XMP:
+            return priv->tag_index->contains(GEXIV2_OPEN_XMP, priv->image->xmpData(), id->name.c_str());
+        case GEXIV2_OPEN_IPTC:
+            return priv->tag_index->contains(GEXIV2_OPEN_IPTC, priv->image->iptcData(), id->name.c_str());
+        default:
+            g_return_val_if_reached(FALSE);
+    }
+}
+
+gchar* gexiv2_metadata_get_tag_string_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), nullptr);
+    g_return_val_if_fail(id != nullptr, nullptr);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    if (!gexiv2_metadata_check_family_loaded(self, id->name.c_str(), error))
+        return nullptr;
+
+    switch (id->family) {
+        case GEXIV2_OPEN_EXIF:
+            return gexiv2_metadata_get_exif_tag_string(self, static_cast<const Exiv2::ExifKey&>(*id->key), error);
+        case GEXIV2_OPEN_XMP:
+            return gexiv2_metadata_get_xmp_tag_string(self, static_cast<const Exiv2::XmpKey&>(*id->key), error);
+        case GEXIV2_OPEN_IPTC:
+            return gexiv2_metadata_get_iptc_tag_string(self, static_cast<const Exiv2::IptcKey&>(*id->key), error);
+        default:
+            g_return_val_if_reached(nullptr);
+    }
+}
+
+gboolean gexiv2_metadata_set_tag_string_by_id(GExiv2Metadata* self,
+                                              const GExiv2TagId* id,
+                                              const gchar* value,
+                                              GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), FALSE);
+    g_return_val_if_fail(id != nullptr, FALSE);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    if (!gexiv2_metadata_check_family_loaded(self, id->name.c_str(), error))
+        return FALSE;
+
+    switch (id->family) {
+        case GEXIV2_OPEN_EXIF:
+            return gexiv2_metadata_set_exif_tag_string(self, static_cast<const Exiv2::ExifKey&>(*id->key), value,
+                                                       error);
+        case GEXIV2_OPEN_XMP:
+            return gexiv2_metadata_set_xmp_tag_string(self, static_cast<const Exiv2::XmpKey&>(*id->key), value,
+                                                      error);
+        case GEXIV2_OPEN_IPTC:
+            return gexiv2_metadata_set_iptc_tag_string(self, static_cast<const Exiv2::IptcKey&>(*id->key), value,
+                                                       error);
+        default:
+            g_return_val_if_reached(FALSE);
+    }
+}
+
+glong gexiv2_metadata_get_tag_long_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_METADATA(self), 0);
+    g_return_val_if_fail(id != nullptr, 0);
+    auto* priv = gexiv2_priv(self);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, 0);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, 0);
+
+    if (!gexiv2_metadata_check_family_loaded(self, id->name.c_str(), error))
+        return 0;
+
+    switch (id->family) {
+        case GEXIV2_OPEN_EXIF:
+            return gexiv2_metadata_get_exif_tag_long(self, static_cast<const Exiv2::ExifKey&>(*id->key), error);
+        case GEXIV2_OPEN_XMP:
+            return gexiv2_metadata_get_xmp_tag_long(self, static_cast<const Exiv2::XmpKey&>(*id->key), error);
+        default:
+            // Same as gexiv2_metadata_get_tag_long()
+            g_set_error_literal(error, g_quark_from_string("GExiv2"),
+                                static_cast<int>(Exiv2::ErrorCode::kerInvalidKey), id->name.c_str());
+            return 0;
+    }
+}
+
 G_END_DECLS
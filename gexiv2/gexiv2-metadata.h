@@ -15,6 +15,9 @@
 #include <gio/gio.h>
 #include <gexiv2/gexiv2-preview-properties.h>
 #include <gexiv2/gexiv2-preview-image.h>
+#include <gexiv2/gexiv2-tag-id.h>
+#include <gexiv2/gexiv2-tag-iter.h>
+#include <gexiv2/gexiv2-metadata-batch.h>
 
 G_BEGIN_DECLS
 
@@ -100,6 +103,66 @@ typedef enum { /*< flags >*/
   GEXIV2_OMIT_ALL_FORMATTING   = 0x0800UL
 } GExiv2XmpFormatFlags;
 
+/**
+ * GExiv2OpenFlags:
+ * @GEXIV2_OPEN_EXIF: Decode EXIF metadata
+ * @GEXIV2_OPEN_XMP: Decode XMP metadata
+ * @GEXIV2_OPEN_IPTC: Decode IPTC metadata
+ * @GEXIV2_OPEN_COMMENT: Read the image comment
+ * @GEXIV2_OPEN_PREVIEWS: Make embedded previews available
+ * @GEXIV2_OPEN_ALL: All of the above
+ *
+ * Selects the parts of the metadata that are loaded by
+ * [method@GExiv2.Metadata.open_path_with_flags] and
+ * [method@GExiv2.Metadata.from_stream_with_flags].
+ *
+ * Since: 0.17.0
+ */
+typedef enum { /*< flags >*/
+  GEXIV2_OPEN_EXIF     = 1 << 0,
+  GEXIV2_OPEN_XMP      = 1 << 1,
+  GEXIV2_OPEN_IPTC     = 1 << 2,
+  GEXIV2_OPEN_COMMENT  = 1 << 3,
+  GEXIV2_OPEN_PREVIEWS = 1 << 4,
+  GEXIV2_OPEN_ALL      = 0x1f
+} GExiv2OpenFlags;
+
+/**
+ * GExiv2SaveMethod:
+ * @GEXIV2_SAVE_METHOD_NONE: Nothing was written, the file already had the metadata
+ * @GEXIV2_SAVE_METHOD_IN_PLACE: The metadata was written over the old metadata in the file
+ * @GEXIV2_SAVE_METHOD_REWRITE: The whole file was written again
+ *
+ * How [method@GExiv2.Metadata.save_file_in_place] saved the metadata.
+ *
+ * Since: 0.17.0
+ */
+typedef enum {
+  GEXIV2_SAVE_METHOD_NONE,
+  GEXIV2_SAVE_METHOD_IN_PLACE,
+  GEXIV2_SAVE_METHOD_REWRITE
+} GExiv2SaveMethod;
+
+/**
+ * GExiv2SaveFlags:
+ * @GEXIV2_SAVE_NO_SYNC: Leave flushing the file to disk to the operating system
+ * @GEXIV2_SAVE_DATA_SYNC: Flush the contents of the file to disk before returning
+ * @GEXIV2_SAVE_FULL_SYNC: Flush the contents and the attributes of the file to disk, and the
+ *   directory entry as well with %GEXIV2_SAVE_ATOMIC_RENAME
+ * @GEXIV2_SAVE_ATOMIC_RENAME: Write a temporary file next to the target and rename it over the
+ *   target, so that a crash never leaves a partially written file behind
+ *
+ * Controls how [method@GExiv2.Metadata.save_file_with_flags] writes the file.
+ *
+ * Since: 0.17.0
+ */
+typedef enum { /*< flags >*/
+  GEXIV2_SAVE_NO_SYNC       = 0,
+  GEXIV2_SAVE_DATA_SYNC     = 1 << 0,
+  GEXIV2_SAVE_FULL_SYNC     = 1 << 1,
+  GEXIV2_SAVE_ATOMIC_RENAME = 1 << 2
+} GExiv2SaveFlags;
+
 /**
  * GExiv2ByteOrder:
  * @GEXIV2_BYTE_ORDER_LITTLE: Use little-endian byte order
@@ -153,6 +216,21 @@ struct _GExiv2MetadataClass
  */
 GExiv2Metadata* gexiv2_metadata_new					(void);
 
+/**
+ * gexiv2_metadata_reset:
+ * @self: An instance of [class@GExiv2.Metadata]
+ *
+ * Drops the image and all metadata read from it, leaving @self as if it was just created.
+ *
+ * Buffers and lookup tables that do not depend on the file are kept, so scanners that
+ * process many files one after another can reuse a single [class@GExiv2.Metadata] and
+ * reset it or simply open the next file, instead of creating a new object for each file.
+ * Opening a file resets @self as well.
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_metadata_reset(GExiv2Metadata* self);
+
 /**
  * gexiv2_metadata_open_path:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -170,6 +248,42 @@ GExiv2Metadata* gexiv2_metadata_new					(void);
  */
 gboolean		gexiv2_metadata_open_path			(GExiv2Metadata *self, const gchar *path, GError **error);
 
+/**
+ * gexiv2_metadata_open_path_async:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to open
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the metadata is read
+ * @user_data: (closure): Data to pass to @callback
+ *
+ * Asynchronously populate metadata from @path. See [method@GExiv2.Metadata.open_path]
+ * for the synchronous version.
+ *
+ * The file is read in a worker thread. @self must not be used until @callback
+ * has been called and [method@GExiv2.Metadata.open_path_finish] has been called
+ * to get the result.
+ *
+ * Since: 0.17.0
+ */
+void			gexiv2_metadata_open_path_async		(GExiv2Metadata *self, const gchar *path, GCancellable *cancellable,
+													 GAsyncReadyCallback callback, gpointer user_data);
+
+/**
+ * gexiv2_metadata_open_path_finish:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @result: The [iface@Gio.AsyncResult] passed to the callback
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Finish an operation started with [method@GExiv2.Metadata.open_path_async].
+ *
+ * If the operation was cancelled, @error is set to %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_open_path_finish	(GExiv2Metadata *self, GAsyncResult *result, GError **error);
+
 /**
  * gexiv2_metadata_open_buf:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -204,6 +318,150 @@ gboolean		gexiv2_metadata_open_buf			(GExiv2Metadata *self, const guint8 *data,
  */
 gboolean		gexiv2_metadata_from_stream			(GExiv2Metadata *self, GInputStream* stream, GError **error);
 
+/**
+ * gexiv2_metadata_from_stream_metadata_only:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @stream: A seekable [class@Gio.InputStream]
+ * @bytes_read: (out) (optional): Return location for the number of bytes read from @stream
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Read metadata from a [class@Gio.InputStream] without reading the image data.
+ *
+ * For JPEG files only the segments in front of the image scan are read, for PNG files
+ * only the chunks in front of the first image data chunk, for WebP files everything but
+ * the image data and for TIFF based files only the image file directories and the values
+ * they reference. Other formats are read completely, like
+ * [method@GExiv2.Metadata.from_stream] does.
+ *
+ * Since the image data is not available, [method@GExiv2.Metadata.as_bytes] needs to be
+ * passed the original file contents. For TIFF based files, embedded previews are not
+ * available.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_from_stream_metadata_only	(GExiv2Metadata *self, GInputStream *stream,
+															 guint64 *bytes_read, GError **error);
+
+/**
+ * gexiv2_metadata_open_path_metadata_only:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to open
+ * @bytes_read: (out) (optional): Return location for the number of bytes read from the file
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Populate metadata from the file at @path without reading the image data. See
+ * [method@GExiv2.Metadata.from_stream_metadata_only] for details.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_open_path_metadata_only	(GExiv2Metadata *self, const gchar *path,
+														 guint64 *bytes_read, GError **error);
+
+/**
+ * gexiv2_metadata_from_stream_with_flags:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @stream: A seekable [class@Gio.InputStream]
+ * @flags: The parts of the metadata to load
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Read only the metadata selected by @flags from a [class@Gio.InputStream].
+ *
+ * Like [method@GExiv2.Metadata.from_stream_metadata_only], the image data is not read.
+ * For JPEG, PNG, WebP and TIFF based files, the segments holding metadata that was not
+ * asked for are not read or decoded either, which avoids the cost of parsing XMP if only
+ * EXIF is needed, for example. Other formats are decoded completely and the metadata that
+ * was not asked for is dropped afterwards.
+ *
+ * If @flags is %GEXIV2_OPEN_ALL, the stream is read completely like
+ * [method@GExiv2.Metadata.from_stream] does, so the metadata can be saved with
+ * [method@GExiv2.Metadata.save_to_stream] or [method@GExiv2.Metadata.as_bytes]. The same
+ * goes for TIFF based files if @flags contains %GEXIV2_OPEN_PREVIEWS, as their previews are
+ * stored like the image data.
+ *
+ * Metadata that was not loaded is reported as missing by the functions accessing a whole
+ * family, while accessing a single tag of such a family sets @error. Saving the metadata
+ * leaves the families that were not loaded untouched in the target file.
+ * [method@GExiv2.Metadata.get_open_flags] returns what was loaded.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_from_stream_with_flags	(GExiv2Metadata *self, GInputStream *stream,
+														 GExiv2OpenFlags flags, GError **error);
+
+/**
+ * gexiv2_metadata_open_path_with_flags:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to open
+ * @flags: The parts of the metadata to load
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Populate only the metadata selected by @flags from the file at @path. See
+ * [method@GExiv2.Metadata.from_stream_with_flags] for details.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_open_path_with_flags	(GExiv2Metadata *self, const gchar *path,
+														 GExiv2OpenFlags flags, GError **error);
+
+/**
+ * gexiv2_metadata_get_open_flags:
+ * @self: An instance of [class@GExiv2.Metadata]
+ *
+ * Query which parts of the metadata were loaded when the image was opened.
+ *
+ * Returns: [flags@GExiv2.OpenFlags] of the loaded metadata. This is %GEXIV2_OPEN_ALL unless
+ *   the image was opened with [method@GExiv2.Metadata.open_path_with_flags] or
+ *   [method@GExiv2.Metadata.from_stream_with_flags].
+ *
+ * Since: 0.17.0
+ */
+GExiv2OpenFlags	gexiv2_metadata_get_open_flags		(GExiv2Metadata *self);
+
+/**
+ * gexiv2_metadata_from_stream_async:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @stream: A seekable [class@Gio.InputStream]
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the metadata is read
+ * @user_data: (closure): Data to pass to @callback
+ *
+ * Asynchronously read metadata from a [class@Gio.InputStream]. See
+ * [method@GExiv2.Metadata.from_stream] for the synchronous version.
+ *
+ * The stream is read in a worker thread; @cancellable is also honoured by the
+ * individual reads from @stream. Neither @self nor @stream must be used until
+ * @callback has been called and [method@GExiv2.Metadata.from_stream_finish] has
+ * been called to get the result.
+ *
+ * Since: 0.17.0
+ */
+void			gexiv2_metadata_from_stream_async	(GExiv2Metadata *self, GInputStream *stream, GCancellable *cancellable,
+													 GAsyncReadyCallback callback, gpointer user_data);
+
+/**
+ * gexiv2_metadata_from_stream_finish:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @result: The [iface@Gio.AsyncResult] passed to the callback
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Finish an operation started with [method@GExiv2.Metadata.from_stream_async].
+ *
+ * If the operation was cancelled, @error is set to %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_from_stream_finish	(GExiv2Metadata *self, GAsyncResult *result, GError **error);
+
 /**
  * gexiv2_metadata_from_app1_segment:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -233,6 +491,42 @@ gboolean		gexiv2_metadata_from_app1_segment	(GExiv2Metadata *self, const guint8
  */
 gboolean		gexiv2_metadata_save_external			(GExiv2Metadata *self, const gchar *path, GError **error);
 
+/**
+ * gexiv2_metadata_save_external_async:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to save to.
+ * @progress_callback: (nullable) (scope forever) (closure progress_callback_data): Function to call with the number of bytes written
+ * @progress_callback_data: Data to pass to @progress_callback
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the sidecar is written
+ * @user_data: (closure): Data to pass to @callback
+ *
+ * Asynchronously saves the metadata to an XMP sidecar file. See
+ * [method@GExiv2.Metadata.save_external] for the synchronous version.
+ *
+ * @progress_callback is invoked in the thread-default main context of the caller while the
+ * sidecar is written. If the operation is cancelled, an existing file at @path is left untouched.
+ *
+ * Since: 0.17.0
+ */
+void			gexiv2_metadata_save_external_async		(GExiv2Metadata *self, const gchar *path,
+														 GFileProgressCallback progress_callback, gpointer progress_callback_data,
+														 GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+
+/**
+ * gexiv2_metadata_save_external_finish:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @result: The [iface@Gio.AsyncResult] passed to the callback
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Finish an operation started with [method@GExiv2.Metadata.save_external_async].
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_save_external_finish	(GExiv2Metadata *self, GAsyncResult *result, GError **error);
+
 /**
  * gexiv2_metadata_save_file:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -242,11 +536,122 @@ gboolean		gexiv2_metadata_save_external			(GExiv2Metadata *self, const gchar *pa
  * Saves the metadata to the specified file by reading the file into memory, copying this object's
  * metadata into the image, then writing the image back out.
  *
+ * When @path is the file the metadata was opened from, only the metadata families changed
+ * since it was opened or last saved are copied, and the others are left as they are in the
+ * file. If nothing was changed, the file is not written at all.
+ *
  * Returns: Boolean success indicator.
  *
  */
 gboolean		gexiv2_metadata_save_file			(GExiv2Metadata *self, const gchar *path, GError **error);
 
+/**
+ * gexiv2_metadata_save_file_in_place:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to save to.
+ * @method: (out) (optional): Return location for how the metadata was saved
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Saves the metadata to the specified file like [method@GExiv2.Metadata.save_file], but
+ * tries to patch the file in place first.
+ *
+ * If XMP is the only changed family and @path is a JPEG or TIFF file with a writeable XMP packet,
+ * the new packet is written over the old one, using up its padding, as long as it fits into
+ * the same number of bytes. Otherwise the file is rewritten as with
+ * [method@GExiv2.Metadata.save_file]. The new packet is generated as
+ * [method@GExiv2.Metadata.generate_xmp_packet] does with %GEXIV2_EXACT_PACKET_LENGTH.
+ *
+ * Returns: Boolean success indicator.
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_save_file_in_place		(GExiv2Metadata *self, const gchar *path, GExiv2SaveMethod *method, GError **error);
+
+/**
+ * gexiv2_metadata_save_file_with_flags:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to save to.
+ * @flags: #GExiv2SaveFlags controlling durability
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Saves the metadata to the specified file like [method@GExiv2.Metadata.save_file], but
+ * renders the new file in memory and writes it out as selected by @flags.
+ *
+ * Without %GEXIV2_SAVE_ATOMIC_RENAME, @path is truncated and written in place, which is the
+ * fastest way on scratch storage. With it, a crash leaves either the old or the new file. If
+ * @path is a symbolic link, the file it points to is replaced, keeping its permissions and, where
+ * the process is allowed to, its owner.
+ * %GEXIV2_SAVE_DATA_SYNC and %GEXIV2_SAVE_FULL_SYNC additionally make sure that the new file
+ * survives a power loss once this function returns.
+ *
+ * Returns: Boolean success indicator.
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_save_file_with_flags	(GExiv2Metadata *self, const gchar *path, GExiv2SaveFlags flags, GError **error);
+
+/**
+ * gexiv2_metadata_save_file_async:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @path: Path to the file you want to save to.
+ * @progress_callback: (nullable) (scope forever) (closure progress_callback_data): Function to call with the number of bytes written
+ * @progress_callback_data: Data to pass to @progress_callback
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @callback: (scope async): A [callback@Gio.AsyncReadyCallback] to call when the file is written
+ * @user_data: (closure): Data to pass to @callback
+ *
+ * Asynchronously saves the metadata to the specified file. See
+ * [method@GExiv2.Metadata.save_file] for the synchronous version.
+ *
+ * The updated file is assembled in memory and then written to a temporary file which replaces
+ * @path once it is complete. @progress_callback is invoked in the thread-default main context
+ * of the caller as the data is written. If the operation is cancelled, the original file is
+ * left untouched.
+ *
+ * @self must not be modified until @callback has been called.
+ *
+ * Since: 0.17.0
+ */
+void			gexiv2_metadata_save_file_async			(GExiv2Metadata *self, const gchar *path,
+														 GFileProgressCallback progress_callback, gpointer progress_callback_data,
+														 GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data);
+
+/**
+ * gexiv2_metadata_save_file_finish:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @result: The [iface@Gio.AsyncResult] passed to the callback
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Finish an operation started with [method@GExiv2.Metadata.save_file_async].
+ *
+ * If the operation was cancelled, @error is set to %G_IO_ERROR_CANCELLED.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean		gexiv2_metadata_save_file_finish		(GExiv2Metadata *self, GAsyncResult *result, GError **error);
+
+/**
+ * gexiv2_metadata_save_to_stream:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @stream: A [class@Gio.OutputStream] to write the image to
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Writes the image with this object's metadata to @stream, which does not need to be
+ * seekable. The new file is handed to @stream as soon as Exiv2 has rendered it, without
+ * writing it to disk or copying it first. @stream is not closed.
+ *
+ * As with [method@GExiv2.Metadata.as_bytes], this needs the image data, so it fails for
+ * metadata opened with [method@GExiv2.Metadata.from_stream_metadata_only] and similar.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_metadata_save_to_stream(GExiv2Metadata* self, GOutputStream* stream, GCancellable* cancellable, GError** error);
+
 /**
  * gexiv2_metadata_as_bytes:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -666,6 +1071,90 @@ gchar*			gexiv2_metadata_get_tag_string		(GExiv2Metadata *self, const gchar* tag
  */
 gboolean		gexiv2_metadata_set_tag_string		(GExiv2Metadata *self, const gchar* tag, const gchar* value, GError **error);
 
+/**
+ * gexiv2_metadata_apply_batch:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @batch: The changes to apply
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Applies all changes recorded in @batch. Each metadata family is walked once for the whole
+ * batch, instead of once per changed tag.
+ *
+ * All tag names and values are checked before anything is changed. If any tag name is
+ * invalid, belongs to a family that was not loaded, or has a value that cannot be converted
+ * to the tag's type, @self is left untouched and @error is set.
+ *
+ * Existing tags keep their position and type, new tags are added in the order of their names.
+ *
+ * Returns: TRUE on success
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_metadata_apply_batch(GExiv2Metadata* self, GExiv2MetadataBatch* batch, GError** error);
+
+/**
+ * gexiv2_metadata_get_tags_batch:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @tags: (array zero-terminated=1): Exiv2 tag names
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Fetches the values of all @tags at once. The values are the same as returned by
+ * [method@GExiv2.Metadata.get_tag_string], but each metadata family is only searched once,
+ * no matter how many tags are requested.
+ *
+ * Tags that are not present are left out of the result. If any of @tags is not a valid
+ * tag name or belongs to a family that was not loaded, %NULL is returned and @error is set.
+ *
+ * Returns: (transfer full) (nullable) (element-type utf8 utf8): A table mapping the requested
+ *   tag names to their values.
+ *
+ * Since: 0.17.0
+ */
+GHashTable* gexiv2_metadata_get_tags_batch(GExiv2Metadata* self, const gchar* const* tags, GError** error);
+
+/**
+ * gexiv2_metadata_get_snapshot:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Exports all EXIF, XMP and IPTC entries in one [struct@GLib.Variant] of type `a(sqays)`.
+ * Each element holds the tag name, the Exiv2 type id, the raw value as returned by
+ * [method@GExiv2.Metadata.get_tag_raw] and the interpreted value as returned by
+ * [method@GExiv2.Metadata.get_tag_interpreted_string] for a single entry. Entries appear
+ * in the order they are stored in, so repeatable IPTC tags show up once per value.
+ *
+ * Invalid UTF-8 in the interpreted values is replaced by '?'.
+ *
+ * The serialized form, available through [method@GLib.Variant.get_data_as_bytes], is a
+ * single contiguous buffer that can be stored or passed to another process as is.
+ *
+ * Returns: (transfer full) (nullable): The metadata of @self
+ *
+ * Since: 0.17.0
+ */
+GVariant* gexiv2_metadata_get_snapshot(GExiv2Metadata* self, GError** error);
+
+/**
+ * gexiv2_metadata_iter_tags:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @families: The metadata families to visit
+ * @sorted: Whether to visit the tags of each family in the order of
+ *   [method@GExiv2.Metadata.get_exif_tags] and its XMP and IPTC counterparts
+ *
+ * Creates an iterator over the tags of @self that reads them in place, without copying the
+ * tag names into an array first. EXIF tags are visited first, then XMP and IPTC tags. Unless
+ * @sorted is set, the tags of a family are visited in the order they are stored in, which
+ * saves sorting them. Repeatable IPTC tags are visited once per value.
+ *
+ * Only @families out of %GEXIV2_OPEN_EXIF, %GEXIV2_OPEN_XMP and %GEXIV2_OPEN_IPTC are used.
+ *
+ * Returns: (transfer full): A new [struct@GExiv2.TagIter], free with
+ *   [method@GExiv2.TagIter.free]
+ *
+ * Since: 0.17.0
+ */
+GExiv2TagIter* gexiv2_metadata_iter_tags(GExiv2Metadata* self, GExiv2OpenFlags families, gboolean sorted);
+
 /**
  * gexiv2_metadata_try_set_xmp_tag_struct:
  * @self: An instance of [class@GExiv2.Metadata]
@@ -910,6 +1399,66 @@ GBytes*			gexiv2_metadata_try_get_tag_raw		(GExiv2Metadata *self, const gchar* t
  */
 GBytes*			gexiv2_metadata_get_tag_raw			(GExiv2Metadata *self, const gchar* tag, GError **error);
 
+/**
+ * gexiv2_metadata_has_tag_by_id:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @id: A tag from [ctor@GExiv2.TagId.new]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Same as [method@GExiv2.Metadata.has_tag], without parsing the tag name.
+ *
+ * Returns: %TRUE if the tag is present.
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_metadata_has_tag_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error);
+
+/**
+ * gexiv2_metadata_get_tag_string_by_id:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @id: A tag from [ctor@GExiv2.TagId.new]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Same as [method@GExiv2.Metadata.get_tag_string], without parsing the tag name.
+ *
+ * Returns: (transfer full) (allow-none): The tag's value as a string
+ *
+ * Since: 0.17.0
+ */
+gchar* gexiv2_metadata_get_tag_string_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error);
+
+/**
+ * gexiv2_metadata_set_tag_string_by_id:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @id: A tag from [ctor@GExiv2.TagId.new]
+ * @value: The value to set or replace the existing value
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Same as [method@GExiv2.Metadata.set_tag_string], without parsing the tag name.
+ *
+ * Returns: %TRUE on success
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_metadata_set_tag_string_by_id(GExiv2Metadata* self,
+                                              const GExiv2TagId* id,
+                                              const gchar* value,
+                                              GError** error);
+
+/**
+ * gexiv2_metadata_get_tag_long_by_id:
+ * @self: An instance of [class@GExiv2.Metadata]
+ * @id: A tag from [ctor@GExiv2.TagId.new]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Same as [method@GExiv2.Metadata.get_tag_long], without parsing the tag name.
+ *
+ * Returns: The tag's value as a glong
+ *
+ * Since: 0.17.0
+ */
+glong gexiv2_metadata_get_tag_long_by_id(GExiv2Metadata* self, const GExiv2TagId* id, GError** error);
+
 /*
  * EXIF functions
  */
@@ -1207,6 +1756,10 @@ gchar**			gexiv2_metadata_get_xmp_tags		(GExiv2Metadata *self);
  *
  * Register an additional XMP namespace.
  *
+ * The namespace registry is shared by all threads. Registering, unregistering and looking up
+ * namespaces through gexiv2 may happen concurrently, but metadata that is being read or written
+ * while the namespace of its tags is unregistered may fail to decode those tags.
+ *
  * Returns: (skip): Boolean success value
  *
  * Since: 0.16.0
@@ -0,0 +1,464 @@
+/*
+ * gexiv2-scanner.cpp
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-scanner.h"
+#include "gexiv2-batch-reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+// Bumped whenever the layout of the index file changes
+constexpr guint32 INDEX_VERSION = 2;
+
+// The index file is a sequence of records, each a little-endian 64-bit length followed by a
+// serialized variant, padded to eight bytes so that every variant is aligned in the mapped
+// file. Entries are written one at a time, so saving never holds a second copy of the index.
+constexpr gsize RECORD_ALIGNMENT = 8;
+
+// The first record: version, flags, tags
+constexpr const char* HEADER_FORMAT = "(uuas)";
+
+// Every other record: path, size, mtime in µs, inode, read ok, tag values
+constexpr const char* ENTRY_FORMAT = "(stttba{ss})";
+
+// Files queued for every reading thread before the walk waits for results
+constexpr guint MAX_QUEUED_PER_THREAD = 64;
+
+constexpr const char* SCAN_ATTRIBUTES = G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_NAME
+                                        "," G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_TIME_MODIFIED
+                                        "," G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC "," G_FILE_ATTRIBUTE_UNIX_INODE;
+
+struct Entry {
+    guint64 size{0};
+    guint64 mtime{0};
+    guint64 inode{0};
+    bool ok{false};
+    // Sorted by tag name
+    std::vector<std::pair<std::string, std::string>> values;
+
+    bool same_file(const Entry& other) const {
+        return size == other.size && mtime == other.mtime && inode == other.inode;
+    }
+};
+
+using Entries = std::unordered_map<std::string, Entry>;
+} // namespace
+
+struct _GExiv2Scanner {
+    GObject parent_instance;
+
+    GExiv2OpenFlags flags;
+    gchar** tags;
+    Entries* entries;
+
+    guint files_read;
+    guint files_unchanged;
+    guint files_failed;
+};
+
+G_DEFINE_TYPE(GExiv2Scanner, gexiv2_scanner, G_TYPE_OBJECT)
+
+static void gexiv2_scanner_finalize(GObject* object) {
+    auto* self = GEXIV2_SCANNER(object);
+
+    delete self->entries;
+    g_strfreev(self->tags);
+
+    G_OBJECT_CLASS(gexiv2_scanner_parent_class)->finalize(object);
+}
+
+static void gexiv2_scanner_class_init(GExiv2ScannerClass* klass) {
+    GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+
+    gobject_class->finalize = gexiv2_scanner_finalize;
+}
+
+static void gexiv2_scanner_init(GExiv2Scanner* self) {
+    self->entries = new Entries();
+}
+
+GExiv2Scanner* gexiv2_scanner_new(GExiv2OpenFlags flags, const gchar* const* tags) {
+    g_return_val_if_fail(tags != nullptr && tags[0] != nullptr, nullptr);
+
+    auto* self = GEXIV2_SCANNER(g_object_new(GEXIV2_TYPE_SCANNER, nullptr));
+    self->flags = flags;
+    self->tags = g_strdupv(const_cast<gchar**>(tags));
+
+    return self;
+}
+
+static void gexiv2_scanner_count_failed(GExiv2Scanner* self) {
+    self->files_failed = static_cast<guint>(
+        std::count_if(self->entries->begin(), self->entries->end(), [](const auto& it) { return !it.second.ok; }));
+}
+
+// The variant of the record at offset in bytes, advancing offset past it. Returns nullptr and
+// leaves offset alone at the end of the file or if the record does not fit into it.
+static GVariant* gexiv2_scanner_read_record(GBytes* bytes, gsize& offset, const gchar* format) {
+    gsize size = 0;
+    const auto* data = static_cast<const guint8*>(g_bytes_get_data(bytes, &size));
+
+    guint64 length = 0;
+    if (size - offset < sizeof(length))
+        return nullptr;
+
+    memcpy(&length, data + offset, sizeof(length));
+    length = GUINT64_FROM_LE(length);
+    auto start = offset + sizeof(length);
+    if (length > size - start)
+        return nullptr;
+
+    auto end = start + length;
+    end += (RECORD_ALIGNMENT - end % RECORD_ALIGNMENT) % RECORD_ALIGNMENT;
+    if (end > size)
+        return nullptr;
+
+    // The index comes from disk, so it is not trusted to be in normal form
+    g_autoptr(GBytes) record = g_bytes_new_from_bytes(bytes, start, length);
+    offset = end;
+
+    return g_variant_ref_sink(g_variant_new_from_bytes(G_VARIANT_TYPE(format), record, FALSE));
+}
+
+gboolean gexiv2_scanner_load_index(GExiv2Scanner* self, const gchar* path, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    self->entries->clear();
+    self->files_failed = 0;
+
+    GError* inner_error = nullptr;
+    g_autoptr(GMappedFile) mapped = g_mapped_file_new(path, FALSE, &inner_error);
+    if (mapped == nullptr) {
+        if (g_error_matches(inner_error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+            g_error_free(inner_error);
+
+            return TRUE;
+        }
+
+        g_propagate_error(error, inner_error);
+
+        return FALSE;
+    }
+
+    g_autoptr(GBytes) bytes = g_mapped_file_get_bytes(mapped);
+    gsize offset = 0;
+    g_autoptr(GVariant) header = gexiv2_scanner_read_record(bytes, offset, HEADER_FORMAT);
+    if (header == nullptr)
+        return TRUE;
+
+    guint32 version = 0;
+    guint32 flags = 0;
+    g_autofree const gchar** tags = nullptr;
+    g_variant_get(header, "(uu^a&s)", &version, &flags, &tags);
+
+    // Values of other tags or flags would be wrong, so every file has to be read again
+    if (version != INDEX_VERSION || flags != static_cast<guint32>(self->flags) ||
+        g_strv_length(const_cast<gchar**>(tags)) != g_strv_length(self->tags))
+        return TRUE;
+
+    for (guint i = 0; tags[i] != nullptr; i++) {
+        if (g_strcmp0(tags[i], self->tags[i]) != 0)
+            return TRUE;
+    }
+
+    while (auto* record = gexiv2_scanner_read_record(bytes, offset, ENTRY_FORMAT)) {
+        const gchar* entry_path = nullptr;
+        guint64 size = 0;
+        guint64 mtime = 0;
+        guint64 inode = 0;
+        gboolean ok = FALSE;
+        GVariantIter* values = nullptr;
+        g_variant_get(record, "(&stttba{ss})", &entry_path, &size, &mtime, &inode, &ok, &values);
+
+        auto& entry = (*self->entries)[entry_path];
+        entry.size = size;
+        entry.mtime = mtime;
+        entry.inode = inode;
+        entry.ok = ok;
+
+        const gchar* tag = nullptr;
+        const gchar* value = nullptr;
+        while (g_variant_iter_next(values, "{&s&s}", &tag, &value))
+            entry.values.emplace_back(tag, value);
+        std::sort(entry.values.begin(), entry.values.end());
+
+        g_variant_iter_free(values);
+        g_variant_unref(record);
+    }
+
+    // A truncated index is incomplete, so it is not used at all
+    if (offset != g_bytes_get_size(bytes))
+        self->entries->clear();
+
+    gexiv2_scanner_count_failed(self);
+
+    return TRUE;
+}
+
+static gboolean gexiv2_scanner_write_record(GOutputStream* stream, GVariant* record, GError** error) {
+    static const guint8 padding[RECORD_ALIGNMENT] = {0};
+    auto size = g_variant_get_size(record);
+    auto length = GUINT64_TO_LE(static_cast<guint64>(size));
+
+    return g_output_stream_write_all(stream, &length, sizeof(length), nullptr, nullptr, error) &&
+           g_output_stream_write_all(stream, g_variant_get_data(record), size, nullptr, nullptr, error) &&
+           g_output_stream_write_all(stream, padding, (RECORD_ALIGNMENT - size % RECORD_ALIGNMENT) % RECORD_ALIGNMENT,
+                                     nullptr, nullptr, error);
+}
+
+gboolean gexiv2_scanner_save_index(GExiv2Scanner* self, const gchar* path, GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), FALSE);
+    g_return_val_if_fail(path != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    // The file is only replaced once the stream is closed successfully
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+    g_autoptr(GFileOutputStream) file_stream =
+        g_file_replace(file, nullptr, FALSE, G_FILE_CREATE_NONE, nullptr, error);
+    if (file_stream == nullptr)
+        return FALSE;
+
+    g_autoptr(GOutputStream) stream = g_buffered_output_stream_new(G_OUTPUT_STREAM(file_stream));
+
+    g_autoptr(GVariant) header = g_variant_ref_sink(
+        g_variant_new("(uu^as)", INDEX_VERSION, static_cast<guint32>(self->flags), self->tags));
+    auto success = gexiv2_scanner_write_record(stream, header, error);
+
+    for (auto it = self->entries->begin(); success && it != self->entries->end(); ++it) {
+        const auto& [entry_path, entry] = *it;
+
+        GVariantBuilder values;
+        g_variant_builder_init(&values, G_VARIANT_TYPE("a{ss}"));
+        for (const auto& [tag, value] : entry.values)
+            g_variant_builder_add(&values, "{ss}", tag.c_str(), value.c_str());
+
+        g_autoptr(GVariant) record =
+            g_variant_ref_sink(g_variant_new(ENTRY_FORMAT, entry_path.c_str(), entry.size, entry.mtime, entry.inode,
+                                             static_cast<gboolean>(entry.ok), &values));
+        success = gexiv2_scanner_write_record(stream, record, error);
+    }
+
+    if (success && g_output_stream_flush(stream, nullptr, error))
+        return g_output_stream_close(stream, nullptr, error);
+
+    // Closing the replacement with a cancelled cancellable drops it and leaves the old index
+    g_autoptr(GCancellable) cancelled = g_cancellable_new();
+    g_cancellable_cancel(cancelled);
+    g_output_stream_close(stream, cancelled, nullptr);
+
+    return FALSE;
+}
+
+namespace {
+struct Scan {
+    GExiv2Scanner* self;
+    GExiv2BatchReader* reader;
+    GCancellable* cancellable;
+    // Files handed to the reader whose results were not taken yet, and the limit for them
+    guint queued;
+    guint max_queued;
+    Entries found;
+};
+} // namespace
+
+// Records the values read for a changed file
+static void gexiv2_scanner_store(Scan& scan, GExiv2BatchResult* result) {
+    auto it = scan.found.find(gexiv2_batch_result_get_path(result));
+    g_assert(it != scan.found.end());
+
+    auto& entry = it->second;
+    auto* tags = gexiv2_batch_result_get_tags(result);
+    entry.ok = tags != nullptr;
+
+    if (tags != nullptr) {
+        GHashTableIter iter;
+        gpointer tag = nullptr;
+        gpointer value = nullptr;
+
+        g_hash_table_iter_init(&iter, tags);
+        while (g_hash_table_iter_next(&iter, &tag, &value))
+            entry.values.emplace_back(static_cast<const gchar*>(tag), static_cast<const gchar*>(value));
+        std::sort(entry.values.begin(), entry.values.end());
+    }
+
+    scan.self->files_read++;
+    scan.queued--;
+    gexiv2_batch_result_unref(result);
+}
+
+static gboolean gexiv2_scanner_walk(Scan& scan, GFile* directory, gboolean is_root, GError** error) {
+    GError* inner_error = nullptr;
+    g_autoptr(GFileEnumerator) children = g_file_enumerate_children(
+        directory, SCAN_ATTRIBUTES, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, scan.cancellable, &inner_error);
+
+    if (children == nullptr) {
+        // Unreadable directories below the root are left out of the index
+        if (is_root || g_error_matches(inner_error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_propagate_error(error, inner_error);
+
+            return FALSE;
+        }
+
+        g_error_free(inner_error);
+
+        return TRUE;
+    }
+
+    while (TRUE) {
+        GFileInfo* info = nullptr;
+        GFile* child = nullptr;
+
+        if (!g_file_enumerator_iterate(children, &info, &child, scan.cancellable, error))
+            return FALSE;
+
+        if (info == nullptr)
+            break;
+
+        auto type = g_file_info_get_file_type(info);
+        if (type == G_FILE_TYPE_DIRECTORY) {
+            if (!gexiv2_scanner_walk(scan, child, FALSE, error))
+                return FALSE;
+
+            continue;
+        }
+
+        if (type != G_FILE_TYPE_REGULAR)
+            continue;
+
+        g_autofree gchar* path = g_file_get_path(child);
+        if (path == nullptr)
+            continue;
+
+        Entry entry;
+        entry.size = static_cast<guint64>(g_file_info_get_size(info));
+        entry.mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+                      g_file_info_get_attribute_uint32(info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+        entry.inode = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_UNIX_INODE);
+
+        auto known = scan.self->entries->find(path);
+        if (known != scan.self->entries->end() && known->second.same_file(entry)) {
+            scan.found.emplace(path, known->second);
+            scan.self->files_unchanged++;
+        } else {
+            scan.found.emplace(path, std::move(entry));
+            gexiv2_batch_reader_add_path(scan.reader, path);
+            scan.queued++;
+        }
+
+        // The reader queues files without limit, so on a first scan of a large tree the walk
+        // has to wait for the workers instead of queueing every path it finds
+        while (scan.queued >= scan.max_queued) {
+            auto* result = gexiv2_batch_reader_next(scan.reader);
+            if (result == nullptr)
+                break;
+
+            gexiv2_scanner_store(scan, result);
+        }
+
+        // Keep the workers busy without letting results pile up
+        while (auto* result = gexiv2_batch_reader_try_next(scan.reader))
+            gexiv2_scanner_store(scan, result);
+    }
+
+    return TRUE;
+}
+
+gboolean gexiv2_scanner_scan(GExiv2Scanner* self,
+                             const gchar* root,
+                             guint max_threads,
+                             GCancellable* cancellable,
+                             GError** error) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), FALSE);
+    g_return_val_if_fail(root != nullptr, FALSE);
+    g_return_val_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    self->files_read = 0;
+    self->files_unchanged = 0;
+
+    g_autoptr(GExiv2BatchReader) reader = gexiv2_batch_reader_new(self->flags, self->tags, max_threads, 0);
+    g_autoptr(GFile) directory = g_file_new_for_path(root);
+    auto threads = max_threads != 0 ? max_threads : g_get_num_processors();
+    Scan scan{self, reader, cancellable, 0, MAX_QUEUED_PER_THREAD * threads, {}};
+
+    if (!gexiv2_scanner_walk(scan, directory, TRUE, error))
+        return FALSE;
+
+    gexiv2_batch_reader_close(reader);
+    while (auto* result = gexiv2_batch_reader_next(reader)) {
+        gexiv2_scanner_store(scan, result);
+
+        if (g_cancellable_set_error_if_cancelled(cancellable, error))
+            return FALSE;
+    }
+
+    // Files that were not found any more drop out here
+    std::swap(*self->entries, scan.found);
+    gexiv2_scanner_count_failed(self);
+
+    return TRUE;
+}
+
+gchar** gexiv2_scanner_get_paths(GExiv2Scanner* self) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), nullptr);
+
+    std::vector<const std::string*> paths;
+    for (const auto& [path, entry] : *self->entries) {
+        if (entry.ok)
+            paths.push_back(&path);
+    }
+    std::sort(paths.begin(), paths.end(), [](const auto* a, const auto* b) { return *a < *b; });
+
+    auto** result = g_new(gchar*, paths.size() + 1);
+    for (size_t i = 0; i < paths.size(); i++)
+        result[i] = g_strdup(paths[i]->c_str());
+    result[paths.size()] = nullptr;
+
+    return result;
+}
+
+const gchar* gexiv2_scanner_get_tag_string(GExiv2Scanner* self, const gchar* path, const gchar* tag) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), nullptr);
+    g_return_val_if_fail(path != nullptr, nullptr);
+    g_return_val_if_fail(tag != nullptr, nullptr);
+
+    auto it = self->entries->find(path);
+    if (it == self->entries->end())
+        return nullptr;
+
+    const auto& values = it->second.values;
+    auto value = std::lower_bound(values.begin(), values.end(), tag,
+                                  [](const auto& item, const gchar* key) { return item.first < key; });
+    if (value == values.end() || value->first != tag)
+        return nullptr;
+
+    return value->second.c_str();
+}
+
+guint gexiv2_scanner_get_files_read(GExiv2Scanner* self) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), 0);
+
+    return self->files_read;
+}
+
+guint gexiv2_scanner_get_files_unchanged(GExiv2Scanner* self) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), 0);
+
+    return self->files_unchanged;
+}
+
+guint gexiv2_scanner_get_files_failed(GExiv2Scanner* self) {
+    g_return_val_if_fail(GEXIV2_IS_SCANNER(self), 0);
+
+    return self->files_failed;
+}
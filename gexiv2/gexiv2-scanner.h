@@ -0,0 +1,166 @@
+/*
+ * gexiv2-scanner.h
+ *
+ * Incremental metadata index over a directory tree
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_SCANNER_H
+#define GEXIV2_SCANNER_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <gexiv2/gexiv2-metadata.h>
+
+G_BEGIN_DECLS
+
+#define GEXIV2_TYPE_SCANNER (gexiv2_scanner_get_type())
+
+G_DECLARE_FINAL_TYPE(GExiv2Scanner, gexiv2_scanner, GEXIV2, SCANNER, GObject)
+
+/**
+ * GExiv2Scanner:
+ *
+ * Keeps an index of a set of tags for every file below a directory.
+ *
+ * Each file in the index is recorded with its size, modification time and inode. When the
+ * directory is scanned again, files for which these did not change keep their indexed values
+ * and are not opened. Files that cannot be read are recorded as well, so they are not tried
+ * again until they change.
+ *
+ * ```c
+ * scanner = gexiv2_scanner_new(GEXIV2_OPEN_EXIF | GEXIV2_OPEN_XMP, tags);
+ * gexiv2_scanner_load_index(scanner, "catalogue.index", &error);
+ * gexiv2_scanner_scan(scanner, "/srv/photos", 0, NULL, &error);
+ * gexiv2_scanner_save_index(scanner, "catalogue.index", &error);
+ * ```
+ *
+ * Since: 0.17.0
+ */
+
+/**
+ * gexiv2_scanner_new:
+ * @flags: The parts of the metadata to read, see [method@GExiv2.Metadata.open_path_with_flags]
+ * @tags: (array zero-terminated=1): The tags to index
+ *
+ * Returns: (transfer full): A new [class@GExiv2.Scanner] with an empty index
+ *
+ * Since: 0.17.0
+ */
+GExiv2Scanner* gexiv2_scanner_new(GExiv2OpenFlags flags, const gchar* const* tags);
+
+/**
+ * gexiv2_scanner_load_index:
+ * @self: A [class@GExiv2.Scanner]
+ * @path: The index file
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Replaces the index of @self by the one stored at @path.
+ *
+ * A missing file is not an error, it leaves the index empty. An index that was written for
+ * other tags or flags is dropped as well, since all files need to be read again for it.
+ *
+ * Returns: %FALSE if @path exists but could not be read
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_scanner_load_index(GExiv2Scanner* self, const gchar* path, GError** error);
+
+/**
+ * gexiv2_scanner_save_index:
+ * @self: A [class@GExiv2.Scanner]
+ * @path: The index file
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Writes the index of @self to @path, replacing it atomically.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_scanner_save_index(GExiv2Scanner* self, const gchar* path, GError** error);
+
+/**
+ * gexiv2_scanner_scan:
+ * @self: A [class@GExiv2.Scanner]
+ * @root: The directory to scan
+ * @max_threads: The number of threads reading files, 0 for one per processor
+ * @cancellable: (nullable): A [class@Gio.Cancellable] or %NULL
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Walks the regular files below @root, without following symbolic links, and updates the
+ * index for them. Files that changed since they were indexed are read on a
+ * [class@GExiv2.BatchReader]. Afterwards the index holds exactly the files found.
+ *
+ * Directories that cannot be listed are skipped. If the scan fails or is cancelled, the index
+ * is left as it was.
+ *
+ * Returns: Boolean success indicator
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_scanner_scan(GExiv2Scanner* self,
+                             const gchar* root,
+                             guint max_threads,
+                             GCancellable* cancellable,
+                             GError** error);
+
+/**
+ * gexiv2_scanner_get_paths:
+ * @self: A [class@GExiv2.Scanner]
+ *
+ * Returns: (transfer full) (array zero-terminated=1): The sorted paths of all indexed files
+ *   that could be read
+ *
+ * Since: 0.17.0
+ */
+gchar** gexiv2_scanner_get_paths(GExiv2Scanner* self);
+
+/**
+ * gexiv2_scanner_get_tag_string:
+ * @self: A [class@GExiv2.Scanner]
+ * @path: An indexed file
+ * @tag: One of the indexed tags
+ *
+ * Returns: (transfer none) (nullable): The indexed value of @tag for @path, as returned by
+ *   [method@GExiv2.Metadata.get_tag_string], or %NULL if the file did not have the tag
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_scanner_get_tag_string(GExiv2Scanner* self, const gchar* path, const gchar* tag);
+
+/**
+ * gexiv2_scanner_get_files_read:
+ * @self: A [class@GExiv2.Scanner]
+ *
+ * Returns: The number of files opened by the last scan, including the ones that failed
+ *
+ * Since: 0.17.0
+ */
+guint gexiv2_scanner_get_files_read(GExiv2Scanner* self);
+
+/**
+ * gexiv2_scanner_get_files_unchanged:
+ * @self: A [class@GExiv2.Scanner]
+ *
+ * Returns: The number of files the last scan took from the index without opening them
+ *
+ * Since: 0.17.0
+ */
+guint gexiv2_scanner_get_files_unchanged(GExiv2Scanner* self);
+
+/**
+ * gexiv2_scanner_get_files_failed:
+ * @self: A [class@GExiv2.Scanner]
+ *
+ * Returns: The number of files in the index that could not be read, for example because
+ *   they are not images
+ *
+ * Since: 0.17.0
+ */
+guint gexiv2_scanner_get_files_failed(GExiv2Scanner* self);
+
+G_END_DECLS
+
+#endif /* GEXIV2_SCANNER_H */
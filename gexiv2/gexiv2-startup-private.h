@@ -0,0 +1,20 @@
+/*
+ * gexiv2-startup-private.h
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_STARTUP_PRIVATE_H
+#define GEXIV2_STARTUP_PRIVATE_H
+
+#include <gexiv2/gexiv2-startup.h>
+
+G_BEGIN_DECLS
+
+/* Initializes the XMP toolkit with its lock, safe to call more than once. Exiv2 only takes the
+ * lock on the first initialization, so this has to run before anything touches XMP. */
+G_GNUC_INTERNAL gboolean gexiv2_initialize_xmp(void);
+
+G_END_DECLS
+
+#endif /* GEXIV2_STARTUP_PRIVATE_H */
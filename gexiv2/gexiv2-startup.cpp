@@ -8,11 +8,41 @@
  */
 
 #include <exiv2/exiv2.hpp>
+#include "gexiv2-log-private.h"
 #include "gexiv2-startup.h"
+#include "gexiv2-startup-private.h"
 #include "gexiv2-version.h"
 
+namespace {
+// The XMP toolkit is not thread-safe, Exiv2 takes this lock around every call into it
+GRecMutex xmp_toolkit_lock;
+
+void gexiv2_lock_xmp_toolkit(void* data, bool lock) {
+    auto* mutex = static_cast<GRecMutex*>(data);
+
+    if (lock)
+        g_rec_mutex_lock(mutex);
+    else
+        g_rec_mutex_unlock(mutex);
+}
+} // namespace
+
+gboolean gexiv2_initialize_xmp(void) {
+    static gsize initialized = 0;
+
+    // Stored off by one, g_once_init_leave() does not take 0
+    if (g_once_init_enter(&initialized)) {
+        gboolean result = Exiv2::XmpParser::initialize(gexiv2_lock_xmp_toolkit, &xmp_toolkit_lock);
+        g_once_init_leave(&initialized, result + 1);
+    }
+
+    return initialized - 1;
+}
+
 gboolean gexiv2_initialize(void) {
-    return Exiv2::XmpParser::initialize();
+    gexiv2_log_init();
+
+    return gexiv2_initialize_xmp();
 }
 
 void gexiv2_shutdown(void) {
@@ -29,6 +29,11 @@ G_BEGIN_DECLS
  * made in a thread-safe fashion.  Best practice is to call from the application's main thread and
  * not to use any Gexiv2 code until it has returned.
  *
+ * Once it has returned, separate [class@GExiv2.Metadata] objects may be used on different threads
+ * at the same time, since the XMP toolkit is then guarded by a lock. A single object must only be
+ * used by one thread at a time. The XMP namespace registry may be changed from any thread, see
+ * [func@GExiv2.Metadata.register_xmp_namespace].
+ *
  * Returns: %TRUE if initialized.  If %FALSE, GExiv2 should not be used (unable to initialize
  * properly).
  */
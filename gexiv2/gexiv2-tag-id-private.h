@@ -0,0 +1,37 @@
+/*
+ * gexiv2-tag-id-private.h
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_TAG_ID_PRIVATE_H
+#define GEXIV2_TAG_ID_PRIVATE_H
+
+#include <gexiv2/gexiv2-metadata.h>
+#include <gexiv2/gexiv2-tag-id.h>
+
+#include <exiv2/exiv2.hpp>
+#include <memory>
+#include <string>
+
+G_BEGIN_DECLS
+
+struct _GExiv2TagId
+{
+    gint ref_count{1};
+    /* Exactly one of GEXIV2_OPEN_EXIF, GEXIV2_OPEN_XMP and GEXIV2_OPEN_IPTC */
+    GExiv2OpenFlags family;
+    std::string name;
+    /* An Exiv2::ExifKey, Exiv2::XmpKey or Exiv2::IptcKey, depending on family */
+    std::unique_ptr<Exiv2::Key> key;
+};
+
+G_END_DECLS
+
+namespace detail {
+// Parses tag for internal use, without handing out a reference. Sets error and returns
+// nullptr if tag is not a valid tag name
+G_GNUC_INTERNAL std::unique_ptr<GExiv2TagId> parse_tag_id(const gchar* tag, GError** error);
+} // namespace detail
+
+#endif /* GEXIV2_TAG_ID_PRIVATE_H */
@@ -0,0 +1,87 @@
+/*
+ * gexiv2-tag-id.cpp
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-tag-id.h"
+#include "gexiv2-metadata-private.h"
+#include "gexiv2-tag-id-private.h"
+#include "gexiv2-util-private.h"
+
+#include <exiv2/exiv2.hpp>
+#include <glib-object.h>
+
+G_DEFINE_BOXED_TYPE(GExiv2TagId, gexiv2_tag_id, gexiv2_tag_id_ref, gexiv2_tag_id_unref)
+
+namespace detail {
+
+std::unique_ptr<GExiv2TagId> parse_tag_id(const gchar* tag, GError** error) {
+    auto id = std::make_unique<GExiv2TagId>();
+
+    id->name = tag;
+
+    try {
+        if (gexiv2_metadata_is_exif_tag(tag)) {
+            id->family = GEXIV2_OPEN_EXIF;
+            id->key = std::make_unique<Exiv2::ExifKey>(id->name);
+        } else if (gexiv2_metadata_is_xmp_tag(tag)) {
+            id->family = GEXIV2_OPEN_XMP;
+            id->key = std::make_unique<Exiv2::XmpKey>(id->name);
+        } else if (gexiv2_metadata_is_iptc_tag(tag)) {
+            id->family = GEXIV2_OPEN_IPTC;
+            id->key = std::make_unique<Exiv2::IptcKey>(id->name);
+        } else {
+            // Invalid "familyName"
+            g_set_error_literal(error, g_quark_from_string("GExiv2"),
+                                static_cast<int>(Exiv2::ErrorCode::kerInvalidKey), tag);
+            return nullptr;
+        }
+
+        return id;
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return nullptr;
+}
+
+} // namespace detail
+
+GExiv2TagId* gexiv2_tag_id_new(const gchar* tag, GError** error) {
+    g_return_val_if_fail(tag != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    return detail::parse_tag_id(tag, error).release();
+}
+
+GExiv2TagId* gexiv2_tag_id_ref(GExiv2TagId* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    g_atomic_int_inc(&self->ref_count);
+
+    return self;
+}
+
+void gexiv2_tag_id_unref(GExiv2TagId* self) {
+    g_return_if_fail(self != nullptr);
+
+    if (g_atomic_int_dec_and_test(&self->ref_count))
+        delete self;
+}
+
+const gchar* gexiv2_tag_id_get_name(const GExiv2TagId* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    return self->name.c_str();
+}
+
+const gchar* gexiv2_tag_id_get_type_name(const GExiv2TagId* self, GError** error) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    // Not kept with the id, XMP types change with the registered namespaces
+    return gexiv2_metadata_get_tag_type(self->name.c_str(), error);
+}
@@ -0,0 +1,96 @@
+/*
+ * gexiv2-tag-id.h
+ *
+ * Pre-parsed tag names
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_TAG_ID_H
+#define GEXIV2_TAG_ID_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GEXIV2_TYPE_TAG_ID (gexiv2_tag_id_get_type())
+
+/**
+ * GExiv2TagId:
+ *
+ * A tag name that was parsed once, for use with the `_by_id` accessors of
+ * [class@GExiv2.Metadata].
+ *
+ * A tag id is reference counted and immutable, so it may be shared between threads. It only
+ * holds the parsed name; for XMP tags, the namespace of the prefix is looked up whenever the
+ * id is used.
+ *
+ * Since: 0.17.0
+ */
+typedef struct _GExiv2TagId GExiv2TagId;
+
+GType gexiv2_tag_id_get_type(void) G_GNUC_CONST;
+
+/**
+ * gexiv2_tag_id_new:
+ * @tag: Exiv2 tag name
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * Parses @tag into a handle for the `_by_id` accessors of [class@GExiv2.Metadata], which
+ * then skip parsing the name on every call.
+ *
+ * The Exiv2 Tag Reference can be found at <http://exiv2.org/metadata.html>
+ *
+ * Returns: (transfer full) (nullable): The handle for @tag, or %NULL if @tag is not a
+ *   valid tag name. Free with [method@GExiv2.TagId.unref].
+ *
+ * Since: 0.17.0
+ */
+GExiv2TagId* gexiv2_tag_id_new(const gchar* tag, GError** error);
+
+/**
+ * gexiv2_tag_id_ref:
+ * @self: A [struct@GExiv2.TagId]
+ *
+ * Returns: (transfer full): @self, with its reference count increased.
+ *
+ * Since: 0.17.0
+ */
+GExiv2TagId* gexiv2_tag_id_ref(GExiv2TagId* self);
+
+/**
+ * gexiv2_tag_id_unref:
+ * @self: (transfer full): A [struct@GExiv2.TagId]
+ *
+ * Decreases the reference count of @self, freeing it when it drops to zero.
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_tag_id_unref(GExiv2TagId* self);
+
+/**
+ * gexiv2_tag_id_get_name:
+ * @self: A [struct@GExiv2.TagId]
+ *
+ * Returns: (transfer none): The tag name @self was created from.
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_tag_id_get_name(const GExiv2TagId* self);
+
+/**
+ * gexiv2_tag_id_get_type_name:
+ * @self: A [struct@GExiv2.TagId]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * The current default type of the tag, as returned by [func@GExiv2.Metadata.get_tag_type].
+ *
+ * Returns: (transfer none) (nullable): The name of the tag's type.
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_tag_id_get_type_name(const GExiv2TagId* self, GError** error);
+
+G_END_DECLS
+
+#endif /* GEXIV2_TAG_ID_H */
@@ -0,0 +1,19 @@
+/*
+ * gexiv2-tag-iter-private.h
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_TAG_ITER_PRIVATE_H
+#define GEXIV2_TAG_ITER_PRIVATE_H
+
+#include <gexiv2/gexiv2-metadata.h>
+#include <gexiv2/gexiv2-tag-iter.h>
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL GExiv2TagIter* gexiv2_tag_iter_new(GExiv2Metadata* metadata, GExiv2OpenFlags families, gboolean sorted);
+
+G_END_DECLS
+
+#endif /* GEXIV2_TAG_ITER_PRIVATE_H */
@@ -0,0 +1,267 @@
+/*
+ * gexiv2-tag-iter.cpp
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "gexiv2-tag-iter.h"
+#include "gexiv2-metadata-private.h"
+#include "gexiv2-tag-iter-private.h"
+#include "gexiv2-util-private.h"
+
+#include <exiv2/exiv2.hpp>
+#include <glib-object.h>
+#include <string>
+#include <vector>
+
+struct _GExiv2TagIter {
+    GExiv2Metadata* metadata;
+    GExiv2OpenFlags families;
+    bool sorted;
+    guint64 generation;
+
+    // Family the iterator is in, 0 before the first call to next()
+    GExiv2OpenFlags family;
+    bool done;
+
+    // Position when not sorted
+    Exiv2::ExifData::const_iterator exif_it;
+    Exiv2::XmpData::const_iterator xmp_it;
+    Exiv2::IptcData::const_iterator iptc_it;
+
+    // Entries of the current family and the position in them when sorted
+    std::vector<const Exiv2::Metadatum*> order;
+    size_t position;
+
+    const Exiv2::Metadatum* current;
+
+    // Storage for the values handed out by the getters
+    std::string key;
+    bool key_valid;
+    std::string value;
+    std::vector<Exiv2::byte> raw;
+};
+
+G_DEFINE_BOXED_TYPE(GExiv2TagIter, gexiv2_tag_iter, gexiv2_tag_iter_copy, gexiv2_tag_iter_free)
+
+GExiv2TagIter* gexiv2_tag_iter_new(GExiv2Metadata* metadata, GExiv2OpenFlags families, gboolean sorted) {
+    auto* priv = gexiv2_priv(metadata);
+    auto* self = new GExiv2TagIter();
+
+    self->metadata = GEXIV2_METADATA(g_object_ref(metadata));
+    self->families = families;
+    self->sorted = sorted;
+    self->generation = priv->tag_index->generation();
+    self->family = static_cast<GExiv2OpenFlags>(0);
+    self->done = false;
+    self->position = 0;
+    self->current = nullptr;
+    self->key_valid = false;
+
+    return self;
+}
+
+GExiv2TagIter* gexiv2_tag_iter_copy(GExiv2TagIter* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+
+    auto* copy = new GExiv2TagIter(*self);
+    g_object_ref(copy->metadata);
+
+    return copy;
+}
+
+void gexiv2_tag_iter_free(GExiv2TagIter* self) {
+    if (self == nullptr)
+        return;
+
+    g_object_unref(self->metadata);
+    delete self;
+}
+
+template<typename T>
+static void gexiv2_tag_iter_sort(GExiv2TagIter* self, const T& container) {
+    std::vector<std::string> keys;
+    std::vector<const Exiv2::Metadatum*> entries;
+
+    keys.reserve(container.count());
+    entries.reserve(container.count());
+    for (const auto& datum : container) {
+        if (datum.count() > 0) {
+            keys.push_back(datum.key());
+            entries.push_back(&datum);
+        }
+    }
+
+    self->order.clear();
+    self->order.reserve(entries.size());
+    for (auto i : detail::sort_order(self->family, keys))
+        self->order.push_back(entries[i]);
+    self->position = 0;
+}
+
+template<typename T>
+static const Exiv2::Metadatum* gexiv2_tag_iter_step(typename T::const_iterator& it, const T& container) {
+    while (it != container.end() && it->count() == 0)
+        ++it;
+
+    if (it == container.end())
+        return nullptr;
+
+    return &*it++;
+}
+
+// Positions the iterator at the start of the family following the current one
+static bool gexiv2_tag_iter_next_family(GExiv2TagIter* self, const Exiv2::Image& image) {
+    do {
+        if (self->family == 0)
+            self->family = GEXIV2_OPEN_EXIF;
+        else if (self->family == GEXIV2_OPEN_EXIF)
+            self->family = GEXIV2_OPEN_XMP;
+        else if (self->family == GEXIV2_OPEN_XMP)
+            self->family = GEXIV2_OPEN_IPTC;
+        else
+            return false;
+    } while ((self->families & self->family) == 0);
+
+    switch (self->family) {
+        case GEXIV2_OPEN_EXIF:
+            if (self->sorted)
+                gexiv2_tag_iter_sort(self, image.exifData());
+            else
+                self->exif_it = image.exifData().begin();
+            break;
+        case GEXIV2_OPEN_XMP:
+            if (self->sorted)
+                gexiv2_tag_iter_sort(self, image.xmpData());
+            else
+                self->xmp_it = image.xmpData().begin();
+            break;
+        default:
+            if (self->sorted)
+                gexiv2_tag_iter_sort(self, image.iptcData());
+            else
+                self->iptc_it = image.iptcData().begin();
+            break;
+    }
+
+    return true;
+}
+
+gboolean gexiv2_tag_iter_next(GExiv2TagIter* self) {
+    g_return_val_if_fail(self != nullptr, FALSE);
+    auto* priv = gexiv2_priv(self->metadata);
+
+    g_return_val_if_fail(priv->image.get() != nullptr, FALSE);
+    g_return_val_if_fail(self->generation == priv->tag_index->generation(), FALSE);
+
+    const Exiv2::Image& image = *priv->image;
+
+    self->current = nullptr;
+    self->key_valid = false;
+
+    if (self->done)
+        return FALSE;
+
+    if (self->family == 0 && !gexiv2_tag_iter_next_family(self, image)) {
+        self->done = true;
+        return FALSE;
+    }
+
+    while (true) {
+        if (self->sorted) {
+            if (self->position < self->order.size())
+                self->current = self->order[self->position++];
+        } else {
+            switch (self->family) {
+                case GEXIV2_OPEN_EXIF:
+                    self->current = gexiv2_tag_iter_step(self->exif_it, image.exifData());
+                    break;
+                case GEXIV2_OPEN_XMP:
+                    self->current = gexiv2_tag_iter_step(self->xmp_it, image.xmpData());
+                    break;
+                default:
+                    self->current = gexiv2_tag_iter_step(self->iptc_it, image.iptcData());
+                    break;
+            }
+        }
+
+        if (self->current != nullptr)
+            return TRUE;
+
+        if (!gexiv2_tag_iter_next_family(self, image)) {
+            self->done = true;
+            return FALSE;
+        }
+    }
+}
+
+const gchar* gexiv2_tag_iter_get_key(GExiv2TagIter* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+    g_return_val_if_fail(self->current != nullptr, nullptr);
+
+    // Exiv2 builds the key on every call, so it is kept until the iterator moves on
+    if (!self->key_valid) {
+        self->key = self->current->key();
+        self->key_valid = true;
+    }
+
+    return self->key.c_str();
+}
+
+const gchar* gexiv2_tag_iter_get_type_name(GExiv2TagIter* self) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+    g_return_val_if_fail(self->current != nullptr, nullptr);
+
+    return self->current->typeName();
+}
+
+glong gexiv2_tag_iter_get_count(GExiv2TagIter* self) {
+    g_return_val_if_fail(self != nullptr, 0);
+    g_return_val_if_fail(self->current != nullptr, 0);
+
+    return static_cast<glong>(self->current->count());
+}
+
+const gchar* gexiv2_tag_iter_get_string(GExiv2TagIter* self, GError** error) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+    g_return_val_if_fail(self->current != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    try {
+        self->value = self->current->toString();
+
+        return self->value.c_str();
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return nullptr;
+}
+
+const guint8* gexiv2_tag_iter_get_raw(GExiv2TagIter* self, gsize* size, GError** error) {
+    g_return_val_if_fail(self != nullptr, nullptr);
+    g_return_val_if_fail(self->current != nullptr, nullptr);
+    g_return_val_if_fail(size != nullptr, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    *size = 0;
+
+    try {
+        self->raw.resize(self->current->size());
+        if (self->raw.empty())
+            return nullptr;
+
+        self->current->copy(self->raw.data(), Exiv2::invalidByteOrder);
+        *size = self->raw.size();
+
+        return self->raw.data();
+    } catch (Exiv2::Error& e) {
+        error << e;
+    } catch (std::exception& e) {
+        error << e;
+    }
+
+    return nullptr;
+}
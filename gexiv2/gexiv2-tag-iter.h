@@ -0,0 +1,132 @@
+/*
+ * gexiv2-tag-iter.h
+ *
+ * Iteration over the tags of a GExiv2Metadata
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef GEXIV2_TAG_ITER_H
+#define GEXIV2_TAG_ITER_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define GEXIV2_TYPE_TAG_ITER (gexiv2_tag_iter_get_type())
+
+/**
+ * GExiv2TagIter:
+ *
+ * Walks the tags of a [class@GExiv2.Metadata] without copying them, see
+ * [method@GExiv2.Metadata.iter_tags].
+ *
+ * The iterator starts before the first tag, so [method@GExiv2.TagIter.next] has to be called
+ * before reading the current tag. Strings and buffers returned by the getters belong to the
+ * iterator and stay valid until the next call to [method@GExiv2.TagIter.next] or until the
+ * iterator is freed.
+ *
+ * The metadata must not be changed while it is iterated.
+ *
+ * Since: 0.17.0
+ */
+typedef struct _GExiv2TagIter GExiv2TagIter;
+
+GType gexiv2_tag_iter_get_type(void) G_GNUC_CONST;
+
+/**
+ * gexiv2_tag_iter_copy:
+ * @self: A [struct@GExiv2.TagIter]
+ *
+ * Returns: (transfer full): A new iterator at the same position as @self.
+ *
+ * Since: 0.17.0
+ */
+GExiv2TagIter* gexiv2_tag_iter_copy(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_free:
+ * @self: (transfer full): A [struct@GExiv2.TagIter]
+ *
+ * Frees @self and releases the metadata it iterates.
+ *
+ * Since: 0.17.0
+ */
+void gexiv2_tag_iter_free(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_next:
+ * @self: A [struct@GExiv2.TagIter]
+ *
+ * Moves @self to the next tag.
+ *
+ * Returns: %FALSE once all tags have been visited, %TRUE otherwise
+ *
+ * Since: 0.17.0
+ */
+gboolean gexiv2_tag_iter_next(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_get_key:
+ * @self: A [struct@GExiv2.TagIter]
+ *
+ * The Exiv2 Tag Reference can be found at <http://exiv2.org/metadata.html>
+ *
+ * Returns: (transfer none): The name of the current tag
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_tag_iter_get_key(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_get_type_name:
+ * @self: A [struct@GExiv2.TagIter]
+ *
+ * Returns: (transfer none): The name of the type the current tag is stored as
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_tag_iter_get_type_name(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_get_count:
+ * @self: A [struct@GExiv2.TagIter]
+ *
+ * Returns: The number of components of the current tag's value
+ *
+ * Since: 0.17.0
+ */
+glong gexiv2_tag_iter_get_count(GExiv2TagIter* self);
+
+/**
+ * gexiv2_tag_iter_get_string:
+ * @self: A [struct@GExiv2.TagIter]
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * The value of the current tag, formatted like [method@GExiv2.Metadata.get_tag_string] does
+ * for single valued tags. Repeatable IPTC tags are visited once per value.
+ *
+ * Returns: (transfer none) (nullable): The value of the current tag as a string
+ *
+ * Since: 0.17.0
+ */
+const gchar* gexiv2_tag_iter_get_string(GExiv2TagIter* self, GError** error);
+
+/**
+ * gexiv2_tag_iter_get_raw:
+ * @self: A [struct@GExiv2.TagIter]
+ * @size: (out): Return location for the size of the value in bytes
+ * @error: (allow-none): A return location for a [struct@GLib.Error] or %NULL
+ *
+ * The raw value of the current tag, as returned by [method@GExiv2.Metadata.get_tag_raw].
+ *
+ * Returns: (transfer none) (nullable) (array length=size): The bytes of the current tag's
+ *   value
+ *
+ * Since: 0.17.0
+ */
+const guint8* gexiv2_tag_iter_get_raw(GExiv2TagIter* self, gsize* size, GError** error);
+
+G_END_DECLS
+
+#endif /* GEXIV2_TAG_ITER_H */
@@ -15,6 +15,11 @@
 #include <gexiv2/gexiv2-preview-image.h>
 #include <gexiv2/gexiv2-log.h>
 #include <gexiv2/gexiv2-startup.h>
+#include <gexiv2/gexiv2-tag-id.h>
+#include <gexiv2/gexiv2-tag-iter.h>
+#include <gexiv2/gexiv2-metadata-batch.h>
+#include <gexiv2/gexiv2-batch-reader.h>
+#include <gexiv2/gexiv2-scanner.h>
 #include <gexiv2/gexiv2-version.h>
 
 #endif /* GEXIV2_H */
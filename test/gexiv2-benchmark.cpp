@@ -0,0 +1,225 @@
+/*
+ * Micro benchmarks for tag lookups
+ *
+ * This library is free software. See COPYING for details
+ *
+ * Run through "meson test --benchmark" or directly, passing the images to
+ * measure on the command line. Lookups are most expensive on files with many
+ * tags, so RAW files with large makernotes are the interesting input, for
+ * example a Nikon NEF or a Canon CR2 with a few hundred Exif tags. The sample
+ * JPEGs used by default have too few tags to show much of a difference.
+ *
+ * Lookups are also timed with a linear search of the Exiv2 containers, which
+ * is what has_tag() did before the tag index, as the baseline.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include <gexiv2/gexiv2.h>
+
+#include <exiv2/exiv2.hpp>
+
+#define ITERATIONS 10000
+
+static const char* const LOOKUP_TAGS[] = {
+    "Exif.Image.Orientation",
+    "Exif.Photo.PixelXDimension",
+    "Exif.Photo.ExposureTime",
+    "Exif.Photo.FNumber",
+    "Exif.GPSInfo.GPSLatitude",
+    "Xmp.tiff.Orientation",
+    "Iptc.Application2.Caption",
+    "exif.image.make",
+    "Exif.Image.DoesNotExist",
+    NULL
+};
+
+static const char* const WRITE_TAGS[] = {
+    "Exif.Image.Artist",
+    "Exif.Image.Copyright",
+    "Exif.Image.ImageDescription",
+    "Exif.Image.Software",
+    "Exif.Photo.UserComment",
+    "Exif.Photo.CameraOwnerName",
+    "Exif.Photo.LensModel",
+    "Xmp.dc.title",
+    "Xmp.dc.description",
+    "Xmp.dc.rights",
+    "Xmp.photoshop.Headline",
+    "Xmp.photoshop.City",
+    "Xmp.photoshop.Country",
+    "Xmp.xmp.CreatorTool",
+    "Iptc.Application2.Headline",
+    "Iptc.Application2.Caption",
+    "Iptc.Application2.City",
+    "Iptc.Application2.CountryName",
+    "Iptc.Application2.Copyright",
+    NULL
+};
+
+static void report(const char* name, guint operations, gdouble seconds)
+{
+    g_print("  %-30s %10.1f ns/op\n", name, seconds * 1e9 / operations);
+}
+
+// The lookup before the tag index: parse the key and search its container from the start
+static bool has_tag_linear(Exiv2::Image& image, const char* tag)
+{
+    try {
+        if (g_str_has_prefix(tag, "Exif.")) {
+            auto& data = image.exifData();
+            return data.findKey(Exiv2::ExifKey(tag)) != data.end();
+        }
+        if (g_str_has_prefix(tag, "Xmp.")) {
+            auto& data = image.xmpData();
+            return data.findKey(Exiv2::XmpKey(tag)) != data.end();
+        }
+        if (g_str_has_prefix(tag, "Iptc.")) {
+            auto& data = image.iptcData();
+            return data.findKey(Exiv2::IptcKey(tag)) != data.end();
+        }
+    } catch (Exiv2::Error&) {
+    }
+
+    return false;
+}
+
+static void benchmark_file(const char* path)
+{
+    GExiv2Metadata* meta = gexiv2_metadata_new();
+    GError* error = NULL;
+    GTimer* timer = NULL;
+    gchar** tags = NULL;
+    guint n_lookups = 0;
+    guint i = 0;
+    guint found = 0;
+
+    if (!gexiv2_metadata_open_path(meta, path, &error)) {
+        g_printerr("%s: %s\n", path, error->message);
+        g_clear_error(&error);
+        g_object_unref(meta);
+
+        return;
+    }
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_print("%s (%u Exif tags)\n", path, g_strv_length(tags));
+    g_strfreev(tags);
+
+    n_lookups = g_strv_length((gchar**) LOOKUP_TAGS);
+    timer = g_timer_new();
+
+    /* Repeated lookups on unchanged metadata, against the same file read by Exiv2 alone */
+    try {
+        auto image = Exiv2::ImageFactory::open(path);
+        image->readMetadata();
+
+        g_timer_start(timer);
+        for (i = 0; i < ITERATIONS; i++) {
+            const char* const* tag = NULL;
+            for (tag = LOOKUP_TAGS; *tag != NULL; tag++)
+                found += has_tag_linear(*image, *tag);
+        }
+        report("linear search (baseline)", ITERATIONS * n_lookups, g_timer_elapsed(timer, NULL));
+    } catch (Exiv2::Error& e) {
+        g_printerr("%s: %s\n", path, e.what());
+    }
+
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS; i++) {
+        const char* const* tag = NULL;
+        for (tag = LOOKUP_TAGS; *tag != NULL; tag++)
+            found += gexiv2_metadata_has_tag(meta, *tag);
+    }
+    report("has_tag", ITERATIONS * n_lookups, g_timer_elapsed(timer, NULL));
+
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS; i++)
+        gexiv2_metadata_clear_tag(meta, "Exif.Image.DoesNotExist");
+    report("clear_tag (absent)", ITERATIONS, g_timer_elapsed(timer, NULL));
+
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS; i++)
+        gexiv2_metadata_get_orientation(meta, NULL);
+    report("get_orientation", ITERATIONS, g_timer_elapsed(timer, NULL));
+
+    /* Dumping every tag, through the tag list and through an iterator */
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS / 100; i++) {
+        gchar** tag = NULL;
+        tags = gexiv2_metadata_get_exif_tags(meta);
+        for (tag = tags; *tag != NULL; tag++)
+            g_free(gexiv2_metadata_get_tag_string(meta, *tag, NULL));
+        g_strfreev(tags);
+    }
+    report("get_exif_tags + get_tag_string", ITERATIONS / 100, g_timer_elapsed(timer, NULL));
+
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS / 100; i++) {
+        GExiv2TagIter* iter = gexiv2_metadata_iter_tags(meta, GEXIV2_OPEN_EXIF, FALSE);
+        while (gexiv2_tag_iter_next(iter)) {
+            gexiv2_tag_iter_get_key(iter);
+            gexiv2_tag_iter_get_string(iter, NULL);
+        }
+        gexiv2_tag_iter_free(iter);
+    }
+    report("iter_tags", ITERATIONS / 100, g_timer_elapsed(timer, NULL));
+
+    /* Re-tagging, one call per tag and as a batch */
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS / 100; i++) {
+        const char* const* tag = NULL;
+        for (tag = WRITE_TAGS; *tag != NULL; tag++)
+            gexiv2_metadata_set_tag_string(meta, *tag, "gexiv2-benchmark", NULL);
+    }
+    report("set_tag_string", ITERATIONS / 100, g_timer_elapsed(timer, NULL));
+
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS / 100; i++) {
+        const char* const* tag = NULL;
+        GExiv2MetadataBatch* batch = gexiv2_metadata_batch_new();
+        for (tag = WRITE_TAGS; *tag != NULL; tag++)
+            gexiv2_metadata_batch_set_tag_string(batch, *tag, "gexiv2-benchmark");
+        gexiv2_metadata_apply_batch(meta, batch, NULL);
+        gexiv2_metadata_batch_free(batch);
+    }
+    report("apply_batch", ITERATIONS / 100, g_timer_elapsed(timer, NULL));
+
+    /* Every write drops the index of its family, so the next lookup pays for
+     * rebuilding it; this is the worst case for interleaved reads and writes */
+    g_timer_start(timer);
+    for (i = 0; i < ITERATIONS / 10; i++) {
+        gexiv2_metadata_set_tag_string(meta, "Exif.Image.Software", "gexiv2-benchmark", NULL);
+        gexiv2_metadata_has_tag(meta, "Exif.Image.Orientation");
+    }
+    report("set_tag_string + has_tag", ITERATIONS / 10, g_timer_elapsed(timer, NULL));
+
+    g_timer_destroy(timer);
+    g_object_unref(meta);
+
+    // Keep the lookups from being optimized away
+    if (found == 0)
+        g_print("  no tags found\n");
+}
+
+int main(int argc, char** argv)
+{
+    int i = 0;
+
+    gexiv2_initialize();
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++)
+            benchmark_file(argv[i]);
+    } else {
+        g_print("Pass a RAW file with a large makernote to see the difference the tag index makes\n");
+        benchmark_file(SAMPLE_PATH "/CaorVN.jpeg");
+        benchmark_file(SAMPLE_PATH "/original.jpg");
+    }
+
+    return 0;
+}
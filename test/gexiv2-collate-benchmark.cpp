@@ -0,0 +1,124 @@
+/*
+ * Micro benchmark for the collation keys used to sort XMP and IPTC tags
+ *
+ * This library is free software. See COPYING for details
+ *
+ * Compares the previous, stream based implementation with the current one on
+ * the XMP keys of the images passed on the command line, and checks that both
+ * produce the same keys.
+ */
+
+#include <glib.h>
+
+#include <gexiv2/gexiv2.h>
+
+#include "gexiv2/gexiv2-collate-private.h"
+
+#include <cctype>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define ITERATIONS 2000
+
+// The implementation before the collation keys were reworked
+static std::string collate_key_streams(const std::string& str) {
+    constexpr char SUPERDIGIT = ':';
+    constexpr char COLLATION_SENTINAL[] = "\x01\x01\x01";
+    constexpr char NUM_SENTINEL = 0x2;
+
+    std::stringstream in{str};
+    std::stringstream out{};
+
+    while (not in.eof()) {
+        while (not std::isdigit(in.peek()) && not in.eof()) {
+            out << static_cast<char>(in.get());
+        }
+
+        if (not in.eof()) {
+            uint64_t number;
+            in >> number;
+
+            std::string to_append(std::to_string(number).length(), SUPERDIGIT);
+
+            out << COLLATION_SENTINAL << NUM_SENTINEL << to_append << number;
+        }
+    }
+
+    out << NUM_SENTINEL;
+
+    return out.str();
+}
+
+static void add_xmp_keys(std::vector<std::string>& keys, const char* path) {
+    GExiv2Metadata* meta = gexiv2_metadata_new();
+    GError* error = nullptr;
+
+    if (gexiv2_metadata_open_path(meta, path, &error)) {
+        gchar** tags = gexiv2_metadata_get_xmp_tags(meta);
+        for (guint i = 0; tags[i] != nullptr; i++)
+            keys.emplace_back(tags[i]);
+        g_strfreev(tags);
+    } else {
+        g_printerr("%s: %s\n", path, error->message);
+        g_clear_error(&error);
+    }
+
+    g_object_unref(meta);
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> keys;
+    std::string buffer;
+    GTimer* timer = nullptr;
+    gsize total = 0;
+
+    gexiv2_initialize();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++)
+            add_xmp_keys(keys, argv[i]);
+    } else {
+        add_xmp_keys(keys, SAMPLE_PATH "/CaorVN.jpeg");
+    }
+
+    // Array items are what the natural order is for, so make sure there are some
+    for (int i = 1; i <= 20; i++) {
+        keys.push_back("Xmp.dc.subject[" + std::to_string(i) + "]");
+        keys.push_back("Xmp.xmpMM.History[" + std::to_string(i) + "]/stEvt:when");
+    }
+
+    for (const auto& key : keys) {
+        if (detail::collate_key(key) != collate_key_streams(key)) {
+            g_printerr("Collation keys differ for %s\n", key.c_str());
+
+            return 1;
+        }
+    }
+
+    g_print("%" G_GSIZE_FORMAT " keys\n", keys.size());
+    timer = g_timer_new();
+
+    g_timer_start(timer);
+    for (guint i = 0; i < ITERATIONS; i++) {
+        for (const auto& key : keys)
+            total += collate_key_streams(key).size();
+    }
+    g_print("  %-28s %10.1f ns/key\n", "streams", g_timer_elapsed(timer, nullptr) * 1e9 / (ITERATIONS * keys.size()));
+
+    g_timer_start(timer);
+    for (guint i = 0; i < ITERATIONS; i++) {
+        for (const auto& key : keys) {
+            buffer.clear();
+            detail::collate_key(key, buffer);
+            total += buffer.size();
+        }
+    }
+    g_print("  %-28s %10.1f ns/key\n", "reused buffer", g_timer_elapsed(timer, nullptr) * 1e9 / (ITERATIONS * keys.size()));
+
+    g_timer_destroy(timer);
+
+    // Keep the loops from being optimized away
+    return total == 0 ? 1 : 0;
+}
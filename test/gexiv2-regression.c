@@ -9,6 +9,7 @@
 #endif
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include <gexiv2/gexiv2.h>
 
@@ -628,6 +629,1841 @@ static void test_nobug_gps(void) {
     g_object_unref(meta);
 }
 
+static void on_open_path_ready(GObject* source, GAsyncResult* res, gpointer user_data) {
+    GMainLoop* loop = user_data;
+    GError* error = NULL;
+    gboolean result = FALSE;
+
+    result = gexiv2_metadata_open_path_finish(GEXIV2_METADATA(source), res, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    g_main_loop_quit(loop);
+}
+
+static void on_open_path_cancelled(GObject* source, GAsyncResult* res, gpointer user_data) {
+    GMainLoop* loop = user_data;
+    GError* error = NULL;
+    gboolean result = FALSE;
+
+    result = gexiv2_metadata_open_path_finish(GEXIV2_METADATA(source), res, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_false(result);
+
+    g_clear_error(&error);
+    g_main_loop_quit(loop);
+}
+
+static void test_nobug_open_async(void) {
+    GExiv2Metadata* meta = NULL;
+    GMainLoop* loop = NULL;
+    GCancellable* cancellable = NULL;
+    GError* error = NULL;
+    gchar* value = NULL;
+
+    loop = g_main_loop_new(NULL, FALSE);
+    meta = gexiv2_metadata_new();
+    g_assert_nonnull(meta);
+
+    gexiv2_metadata_open_path_async(meta, SAMPLE_PATH "/original.jpg", NULL, on_open_path_ready, loop);
+    g_main_loop_run(loop);
+
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(value);
+    g_free(value);
+
+    cancellable = g_cancellable_new();
+    g_cancellable_cancel(cancellable);
+    gexiv2_metadata_open_path_async(meta, SAMPLE_PATH "/original.jpg", cancellable, on_open_path_cancelled, loop);
+    g_main_loop_run(loop);
+
+    g_object_unref(cancellable);
+    g_object_unref(meta);
+    g_main_loop_unref(loop);
+}
+
+static void on_save_file_progress(goffset current, goffset total, gpointer user_data) {
+    goffset* last = user_data;
+
+    g_assert_cmpint(current, >, *last);
+    g_assert_cmpint(current, <=, total);
+    *last = current;
+}
+
+static void on_save_file_ready(GObject* source, GAsyncResult* res, gpointer user_data) {
+    GMainLoop* loop = user_data;
+    GError* error = NULL;
+    gboolean result = FALSE;
+
+    result = gexiv2_metadata_save_file_finish(GEXIV2_METADATA(source), res, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    g_main_loop_quit(loop);
+}
+
+static void on_save_file_cancelled(GObject* source, GAsyncResult* res, gpointer user_data) {
+    GMainLoop* loop = user_data;
+    GError* error = NULL;
+    gboolean result = FALSE;
+
+    result = gexiv2_metadata_save_file_finish(GEXIV2_METADATA(source), res, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_false(result);
+
+    g_clear_error(&error);
+    g_main_loop_quit(loop);
+}
+
+static void test_nobug_save_async(void) {
+    GExiv2Metadata* meta = NULL;
+    GMainLoop* loop = NULL;
+    GCancellable* cancellable = NULL;
+    GError* error = NULL;
+    gboolean result = FALSE;
+    char* comment = NULL;
+    goffset last = 0;
+    GFile* src = NULL;
+    GFile* dest = NULL;
+    const char* tmp_file = "save-async.jpg";
+
+    loop = g_main_loop_new(NULL, FALSE);
+    meta = gexiv2_metadata_new();
+    g_assert_nonnull(meta);
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/no-metadata.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    src = g_file_new_for_path(SAMPLE_PATH "/no-metadata.jpg");
+    dest = g_file_new_for_path(tmp_file);
+    result = g_file_copy(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    gexiv2_metadata_set_comment(meta, LOREM_IPSUM, &error);
+    g_assert_no_error(error);
+
+    // A cancelled save must leave the file alone
+    cancellable = g_cancellable_new();
+    g_cancellable_cancel(cancellable);
+    gexiv2_metadata_save_file_async(meta, tmp_file, NULL, NULL, cancellable, on_save_file_cancelled, loop);
+    g_main_loop_run(loop);
+
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    comment = gexiv2_metadata_get_comment(meta, &error);
+    g_assert_no_error(error);
+    g_assert_null(comment);
+
+    gexiv2_metadata_set_comment(meta, LOREM_IPSUM, &error);
+    g_assert_no_error(error);
+    gexiv2_metadata_save_file_async(meta, tmp_file, on_save_file_progress, &last, NULL, on_save_file_ready, loop);
+    g_main_loop_run(loop);
+
+    // Progress is dispatched via the main context, so flush outstanding reports
+    while (g_main_context_iteration(NULL, FALSE))
+        ;
+    g_assert_cmpint(last, >, 0);
+
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    comment = gexiv2_metadata_get_comment(meta, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(comment, ==, LOREM_IPSUM);
+
+    g_free(comment);
+    g_object_unref(src);
+    g_object_unref(dest);
+    g_object_unref(cancellable);
+    g_object_unref(meta);
+    g_main_loop_unref(loop);
+}
+
+static void test_nobug_from_stream(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* stream_meta = NULL;
+    GFile* file = NULL;
+    GFileInputStream* stream = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar** tags = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    file = g_file_new_for_path(SAMPLE_PATH "/original.jpg");
+    stream = g_file_read(file, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(stream);
+
+    // The stream is read through GioIo's read-ahead buffer, the result has to be identical
+    stream_meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_from_stream(stream_meta, G_INPUT_STREAM(stream), &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    for (gchar** tag = tags; *tag != NULL; tag++) {
+        gchar* expected = gexiv2_metadata_get_tag_string(meta, *tag, NULL);
+        gchar* actual = gexiv2_metadata_get_tag_string(stream_meta, *tag, NULL);
+
+        g_assert_cmpstr(actual, ==, expected);
+
+        g_free(expected);
+        g_free(actual);
+    }
+
+    g_strfreev(tags);
+    g_object_unref(stream);
+    g_object_unref(file);
+    g_object_unref(stream_meta);
+    g_object_unref(meta);
+}
+
+static void test_nobug_metadata_only(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* partial = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    guint64 bytes_read = 0;
+    GBytes* bytes = NULL;
+    gchar** tags = NULL;
+    GStatBuf st;
+
+    g_assert_cmpint(g_stat(SAMPLE_PATH "/original.jpg", &st), ==, 0);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    partial = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path_metadata_only(partial, SAMPLE_PATH "/original.jpg", &bytes_read, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    // Everything from the start of scan on is skipped
+    g_assert_cmpuint(bytes_read, >, 0);
+    g_assert_cmpuint(bytes_read, <, (guint64) st.st_size);
+
+    g_assert_cmpint(gexiv2_metadata_get_pixel_width(partial), ==, gexiv2_metadata_get_pixel_width(meta));
+    g_assert_cmpint(gexiv2_metadata_get_pixel_height(partial), ==, gexiv2_metadata_get_pixel_height(meta));
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    for (gchar** tag = tags; *tag != NULL; tag++) {
+        gchar* expected = gexiv2_metadata_get_tag_string(meta, *tag, NULL);
+        gchar* actual = gexiv2_metadata_get_tag_string(partial, *tag, NULL);
+
+        g_assert_cmpstr(actual, ==, expected);
+
+        g_free(expected);
+        g_free(actual);
+    }
+
+    // There is no image data to write the metadata into
+    bytes = gexiv2_metadata_as_bytes(partial, NULL, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+    g_assert_null(bytes);
+    g_clear_error(&error);
+    g_strfreev(tags);
+
+    // For TIFF only the directories and their values are read, not the strips
+    g_assert_cmpint(g_stat(SAMPLE_PATH "/sample.tif", &st), ==, 0);
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/sample.tif", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_open_path_metadata_only(partial, SAMPLE_PATH "/sample.tif", &bytes_read, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+#ifdef G_OS_UNIX
+    // Elsewhere TIFF is read in full
+    g_assert_cmpuint(bytes_read, <, (guint64) st.st_size);
+#endif
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    for (gchar** tag = tags; *tag != NULL; tag++) {
+        gchar* expected = gexiv2_metadata_get_tag_string(meta, *tag, NULL);
+        gchar* actual = gexiv2_metadata_get_tag_string(partial, *tag, NULL);
+
+        g_assert_cmpstr(actual, ==, expected);
+
+        g_free(expected);
+        g_free(actual);
+    }
+    g_strfreev(tags);
+
+    g_assert_cmpint(gexiv2_metadata_get_tag_long(partial, "Xmp.xmp.Rating", &error), ==, 3);
+    g_assert_no_error(error);
+
+    g_object_unref(partial);
+    g_object_unref(meta);
+}
+
+static void test_nobug_open_flags(void) {
+    GExiv2Metadata* meta = NULL;
+    GOutputStream* stream = NULL;
+    GBytes* bytes = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* value = NULL;
+    gchar** tags = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/description-with-comma.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(gexiv2_metadata_get_open_flags(meta), ==, GEXIV2_OPEN_ALL);
+    g_assert_true(gexiv2_metadata_has_xmp(meta));
+
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/description-with-comma.jpg", GEXIV2_OPEN_EXIF,
+                                                  &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(gexiv2_metadata_get_open_flags(meta), ==, GEXIV2_OPEN_EXIF);
+
+    tags = gexiv2_metadata_get_xmp_tags(meta);
+    g_assert_nonnull(tags);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+    g_assert_null(gexiv2_metadata_get_preview_properties(meta));
+
+    value = gexiv2_metadata_get_tag_string(meta, "Xmp.dc.description", &error);
+    g_assert_error(error, g_quark_from_string("GExiv2"), 501);
+    g_assert_null(value);
+    g_clear_error(&error);
+
+    // EXIF was loaded, the file just does not have any
+    result = gexiv2_metadata_has_tag(meta, "Exif.Image.ImageDescription", &error);
+    g_assert_no_error(error);
+    g_assert_false(result);
+
+    // Asking for everything reads the whole file, so it can be saved again
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/original.jpg", GEXIV2_OPEN_ALL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    stream = g_memory_output_stream_new_resizable();
+    result = gexiv2_metadata_save_to_stream(meta, stream, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpuint(g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(stream)), >, 0);
+
+    bytes = gexiv2_metadata_as_bytes(meta, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(bytes);
+    g_assert_cmpuint(g_bytes_get_size(bytes), >, 0);
+
+    g_bytes_unref(bytes);
+    g_object_unref(stream);
+    g_object_unref(meta);
+}
+
+static void test_nobug_open_flags_formats(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2PreviewProperties** props = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* value = NULL;
+    gchar** tags = NULL;
+    gboolean has_jpeg = FALSE;
+
+    meta = gexiv2_metadata_new();
+
+    // The XMP chunk of the PNG file is left out, EXIF comes from its eXIf chunk
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/sample.png", GEXIV2_OPEN_EXIF, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "GExiv2");
+    g_free(value);
+    tags = gexiv2_metadata_get_xmp_tags(meta);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/sample.png", GEXIV2_OPEN_XMP, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(gexiv2_metadata_get_tag_long(meta, "Xmp.xmp.Rating", &error), ==, 3);
+    g_assert_no_error(error);
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+
+    // The same for the XMP packet tag of the TIFF file
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/sample.tif", GEXIV2_OPEN_EXIF, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "GExiv2");
+    g_free(value);
+    tags = gexiv2_metadata_get_xmp_tags(meta);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+    g_assert_null(gexiv2_metadata_get_preview_properties(meta));
+
+    // Previews of TIFF files need the whole file, the thumbnail in IFD1 is one of them
+    result = gexiv2_metadata_open_path_with_flags(meta, SAMPLE_PATH "/sample.tif",
+                                                  GEXIV2_OPEN_EXIF | GEXIV2_OPEN_PREVIEWS, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    tags = gexiv2_metadata_get_xmp_tags(meta);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+
+    props = gexiv2_metadata_get_preview_properties(meta);
+    g_assert_nonnull(props);
+    for (GExiv2PreviewProperties** prop = props; *prop != NULL; prop++) {
+        GExiv2PreviewImage* image = gexiv2_metadata_get_preview_image(meta, *prop, &error);
+        g_assert_no_error(error);
+        g_assert_nonnull(image);
+
+        if (g_strcmp0(gexiv2_preview_image_get_mime_type(image), "image/jpeg") == 0) {
+            guint32 size = 0;
+            const guint8* data = gexiv2_preview_image_get_data(image, &size);
+
+            g_assert_cmpuint(size, >, 2);
+            g_assert_cmpuint(data[0], ==, 0xff);
+            g_assert_cmpuint(data[1], ==, 0xd8);
+            has_jpeg = TRUE;
+        }
+
+        g_object_unref(image);
+    }
+    g_assert_true(has_jpeg);
+
+    g_object_unref(meta);
+}
+
+static void test_nobug_tag_index(void) {
+    GExiv2Metadata* meta = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    // Lookups ignore the case of the tag name
+    g_assert_true(gexiv2_metadata_has_tag(meta, "Exif.Image.Orientation", &error));
+    g_assert_true(gexiv2_metadata_has_tag(meta, "exif.image.ORIENTATION", &error));
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Exif.Image.Artist", &error));
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Xmp.dc.creator", &error));
+    g_assert_no_error(error);
+
+    // Changes are visible to lookups done before them
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_true(gexiv2_metadata_has_tag(meta, "Exif.Image.Artist", &error));
+
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.dc.creator", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_true(gexiv2_metadata_has_tag(meta, "Xmp.dc.creator", &error));
+
+    g_assert_true(gexiv2_metadata_clear_tag(meta, "EXIF.IMAGE.ARTIST", &error));
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Exif.Image.Artist", &error));
+    g_assert_false(gexiv2_metadata_clear_tag(meta, "Exif.Image.Artist", &error));
+
+    gexiv2_metadata_clear_xmp(meta);
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Xmp.dc.creator", &error));
+
+    gexiv2_metadata_set_orientation(meta, GEXIV2_ORIENTATION_ROT_90, &error);
+    g_assert_no_error(error);
+    g_assert_true(gexiv2_metadata_has_tag(meta, "Xmp.tiff.Orientation", &error));
+
+    gexiv2_metadata_clear(meta);
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Exif.Image.Orientation", &error));
+    g_assert_no_error(error);
+
+    g_object_unref(meta);
+}
+
+static void test_nobug_tag_id(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2TagId* make = NULL;
+    GExiv2TagId* caption = NULL;
+    GExiv2TagId* custom = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* value = NULL;
+
+    make = gexiv2_tag_id_new("Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(make);
+    g_assert_true(gexiv2_tag_id_ref(make) == make);
+    gexiv2_tag_id_unref(make);
+    g_assert_cmpstr(gexiv2_tag_id_get_name(make), ==, "Exif.Image.Make");
+    g_assert_cmpstr(gexiv2_tag_id_get_type_name(make, &error), ==, "Ascii");
+    g_assert_no_error(error);
+
+    caption = gexiv2_tag_id_new("Iptc.Application2.Caption", &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(caption);
+
+    g_assert_null(gexiv2_tag_id_new("Exif.Image.NoSuchTag", &error));
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+
+    g_assert_null(gexiv2_tag_id_new("NoFamily.Image.Make", &error));
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+
+    // The type of an XMP tag follows its namespace, it is not fixed when the id is created
+    result = gexiv2_metadata_register_xmp_namespace("http://example.org/gexiv2/tag-id/", "gexiv2tagid", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    custom = gexiv2_tag_id_new("Xmp.gexiv2tagid.Value", &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(custom);
+    g_assert_cmpstr(gexiv2_tag_id_get_type_name(custom, &error), ==, "XmpText");
+    g_assert_no_error(error);
+
+    result = gexiv2_metadata_unregister_xmp_namespace("http://example.org/gexiv2/tag-id/", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_null(gexiv2_tag_id_get_type_name(custom, &error));
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+    gexiv2_tag_id_unref(custom);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    g_assert_true(gexiv2_metadata_has_tag_by_id(meta, make, &error));
+    g_assert_no_error(error);
+    value = gexiv2_metadata_get_tag_string_by_id(meta, make, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(value);
+    g_assert_cmpstr(value, ==, "NIKON");
+    g_free(value);
+
+    g_assert_false(gexiv2_metadata_has_tag_by_id(meta, caption, &error));
+    result = gexiv2_metadata_set_tag_string_by_id(meta, caption, "A caption", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_true(gexiv2_metadata_has_tag_by_id(meta, caption, &error));
+    value = gexiv2_metadata_get_tag_string(meta, "Iptc.Application2.Caption", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "A caption");
+    g_free(value);
+
+    gexiv2_tag_id_unref(caption);
+    gexiv2_tag_id_unref(make);
+    g_object_unref(meta);
+}
+
+static void test_nobug_tags_batch(void) {
+    GExiv2Metadata* meta = NULL;
+    GHashTable* values = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* orientation = NULL;
+    const gchar* tags[] = {"Exif.Image.Make", "Exif.Image.Orientation", "Exif.Image.Artist",
+                           "Iptc.Application2.Keywords", NULL};
+    const gchar* invalid_tags[] = {"Exif.Image.Make", "Exif.Image.NoSuchTag", NULL};
+    const gchar* keywords[] = {"one", "two", NULL};
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_multiple(meta, "Iptc.Application2.Keywords", keywords, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    values = gexiv2_metadata_get_tags_batch(meta, tags, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(values);
+
+    orientation = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Orientation", &error);
+    g_assert_no_error(error);
+
+    g_assert_cmpuint(g_hash_table_size(values), ==, 3);
+    g_assert_cmpstr(g_hash_table_lookup(values, "Exif.Image.Make"), ==, "NIKON");
+    g_assert_cmpstr(g_hash_table_lookup(values, "Exif.Image.Orientation"), ==, orientation);
+    g_assert_cmpstr(g_hash_table_lookup(values, "Iptc.Application2.Keywords"), ==, "one, two");
+    g_assert_false(g_hash_table_contains(values, "Exif.Image.Artist"));
+    g_hash_table_unref(values);
+    g_free(orientation);
+
+    values = gexiv2_metadata_get_tags_batch(meta, invalid_tags, &error);
+    g_assert_nonnull(error);
+    g_assert_null(values);
+    g_clear_error(&error);
+
+    g_object_unref(meta);
+}
+
+static void test_nobug_snapshot(void) {
+    GExiv2Metadata* meta = NULL;
+    GVariant* snapshot = NULL;
+    GVariantIter iter;
+    gboolean result = FALSE;
+    gboolean found = FALSE;
+    GError* error = NULL;
+    const gchar* key = NULL;
+    const gchar* interpreted = NULL;
+    guint16 type_id = 0;
+    GVariant* raw = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.dc.description", "A description", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    snapshot = gexiv2_metadata_get_snapshot(meta, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(snapshot);
+    g_assert_false(g_variant_is_floating(snapshot));
+    g_assert_cmpstr(g_variant_get_type_string(snapshot), ==, "a(sqays)");
+
+    g_variant_iter_init(&iter, snapshot);
+    while (g_variant_iter_loop(&iter, "(&sq@ay&s)", &key, &type_id, &raw, &interpreted)) {
+        if (g_str_equal(key, "Exif.Image.Make")) {
+            gsize size = 0;
+            const guint8* data = g_variant_get_fixed_array(raw, &size, 1);
+
+            // Ascii, including the terminating NUL
+            g_assert_cmpuint(type_id, ==, 2);
+            g_assert_cmpuint(size, ==, 6);
+            g_assert_cmpmem(data, size, "NIKON", 6);
+            g_assert_cmpstr(interpreted, ==, "NIKON");
+            found = TRUE;
+        }
+
+        g_assert_true(g_str_has_prefix(key, "Exif.") || g_str_has_prefix(key, "Xmp."));
+    }
+    g_assert_true(found);
+
+    g_variant_unref(snapshot);
+    g_object_unref(meta);
+}
+
+static void test_nobug_tag_lists(void) {
+    GExiv2Metadata* meta = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar** tags = NULL;
+    const gchar* keywords[] = {"one", "two", NULL};
+    guint i = 0;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_assert_nonnull(tags);
+    g_assert_true(g_strv_contains((const gchar* const*)tags, "Exif.Image.Make"));
+    g_assert_false(g_strv_contains((const gchar* const*)tags, "Exif.Image.Artist"));
+    for (i = 1; tags[i] != NULL; i++)
+        g_assert_cmpint(strcmp(tags[i - 1], tags[i]), <=, 0);
+    g_strfreev(tags);
+
+    // The lists follow changes made after they were first requested
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_assert_true(g_strv_contains((const gchar* const*)tags, "Exif.Image.Artist"));
+    g_strfreev(tags);
+
+    result = gexiv2_metadata_set_tag_multiple(meta, "Iptc.Application2.Keywords", keywords, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    tags = gexiv2_metadata_get_iptc_tags(meta);
+    g_assert_cmpuint(g_strv_length(tags), ==, 1);
+    g_assert_cmpstr(tags[0], ==, "Iptc.Application2.Keywords");
+    g_strfreev(tags);
+
+    gexiv2_metadata_clear_iptc(meta);
+    tags = gexiv2_metadata_get_iptc_tags(meta);
+    g_assert_cmpuint(g_strv_length(tags), ==, 0);
+    g_strfreev(tags);
+
+    g_object_unref(meta);
+}
+
+static void test_nobug_tag_iter(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2TagIter* iter = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar** tags = NULL;
+    gboolean found_make = FALSE;
+    guint i = 0;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+
+    // Sorted iteration visits the same tags in the same order as the tag list
+    iter = gexiv2_metadata_iter_tags(meta, GEXIV2_OPEN_ALL, TRUE);
+    for (i = 0; gexiv2_tag_iter_next(iter); i++) {
+        g_assert_nonnull(tags[i]);
+        g_assert_cmpstr(gexiv2_tag_iter_get_key(iter), ==, tags[i]);
+    }
+    g_assert_null(tags[i]);
+    g_assert_false(gexiv2_tag_iter_next(iter));
+    gexiv2_tag_iter_free(iter);
+
+    // Unsorted iteration visits them in storage order
+    iter = gexiv2_metadata_iter_tags(meta, GEXIV2_OPEN_EXIF, FALSE);
+    for (i = 0; gexiv2_tag_iter_next(iter); i++) {
+        const guint8* raw = NULL;
+        gsize size = 0;
+
+        g_assert_true(g_strv_contains((const gchar* const*)tags, gexiv2_tag_iter_get_key(iter)));
+        g_assert_cmpint(gexiv2_tag_iter_get_count(iter), >, 0);
+
+        if (g_str_equal(gexiv2_tag_iter_get_key(iter), "Exif.Image.Make")) {
+            g_assert_cmpstr(gexiv2_tag_iter_get_type_name(iter), ==, "Ascii");
+            g_assert_cmpstr(gexiv2_tag_iter_get_string(iter, &error), ==, "NIKON");
+            g_assert_no_error(error);
+
+            raw = gexiv2_tag_iter_get_raw(iter, &size, &error);
+            g_assert_no_error(error);
+            g_assert_cmpuint(size, ==, 6);
+            g_assert_cmpmem(raw, size, "NIKON", 6);
+            found_make = TRUE;
+        }
+    }
+    g_assert_cmpuint(i, ==, g_strv_length(tags));
+    g_assert_true(found_make);
+    gexiv2_tag_iter_free(iter);
+
+    iter = gexiv2_metadata_iter_tags(meta, GEXIV2_OPEN_XMP | GEXIV2_OPEN_IPTC, FALSE);
+    g_assert_false(gexiv2_tag_iter_next(iter));
+    gexiv2_tag_iter_free(iter);
+
+    g_strfreev(tags);
+    g_object_unref(meta);
+}
+
+static void test_nobug_metadata_batch(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2MetadataBatch* batch = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar** values = NULL;
+    gchar* value = NULL;
+    const gchar* subjects[] = {"one", "two", NULL};
+    const gchar* keywords[] = {"three", "four", NULL};
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    batch = gexiv2_metadata_batch_new();
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Artist", "Somebody");
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Artist", "Nobody");
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Make", "Someone");
+    gexiv2_metadata_batch_clear_tag(batch, "Exif.Image.Orientation");
+    gexiv2_metadata_batch_set_tag_multiple(batch, "Xmp.dc.subject", subjects);
+    gexiv2_metadata_batch_set_tag_multiple(batch, "Iptc.Application2.Keywords", keywords);
+
+    result = gexiv2_metadata_apply_batch(meta, batch, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    gexiv2_metadata_batch_free(batch);
+
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Nobody");
+    g_clear_pointer(&value, g_free);
+
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Someone");
+    g_clear_pointer(&value, g_free);
+
+    g_assert_false(gexiv2_metadata_has_tag(meta, "Exif.Image.Orientation", &error));
+    g_assert_no_error(error);
+
+    values = gexiv2_metadata_get_tag_multiple(meta, "Xmp.dc.subject", &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_strv_length(values), ==, 2);
+    g_assert_cmpstr(values[0], ==, "one");
+    g_assert_cmpstr(values[1], ==, "two");
+    g_clear_pointer(&values, g_strfreev);
+
+    values = gexiv2_metadata_get_tag_multiple(meta, "Iptc.Application2.Keywords", &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_strv_length(values), ==, 2);
+    g_assert_cmpstr(values[0], ==, "three");
+    g_assert_cmpstr(values[1], ==, "four");
+    g_clear_pointer(&values, g_strfreev);
+
+    // Nothing is changed if any part of the batch is invalid
+    batch = gexiv2_metadata_batch_new();
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Artist", "Anybody");
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Orientation", "sideways");
+
+    result = gexiv2_metadata_apply_batch(meta, batch, &error);
+    g_assert_error(error, g_quark_from_string("GExiv2"), 501);
+    g_assert_false(result);
+    g_clear_error(&error);
+    gexiv2_metadata_batch_free(batch);
+
+    batch = gexiv2_metadata_batch_new();
+    gexiv2_metadata_batch_set_tag_string(batch, "Exif.Image.Artist", "Anybody");
+    gexiv2_metadata_batch_clear_tag(batch, "Exif.Invalid.Tag");
+
+    result = gexiv2_metadata_apply_batch(meta, batch, &error);
+    g_assert_nonnull(error);
+    g_assert_false(result);
+    g_clear_error(&error);
+    gexiv2_metadata_batch_free(batch);
+
+    value = gexiv2_metadata_get_tag_string(meta, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Nobody");
+    g_clear_pointer(&value, g_free);
+
+    g_object_unref(meta);
+}
+
+static void test_nobug_save_unchanged(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* saved = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    GFile* src = NULL;
+    GFile* dest = NULL;
+    gchar* value = NULL;
+    const char* tmp_file = "save-unchanged.jpg";
+
+    src = g_file_new_for_path(SAMPLE_PATH "/original.jpg");
+    dest = g_file_new_for_path(tmp_file);
+    result = g_file_copy(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_object_unref(src);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    // Replace the file behind the back of meta to see whether saving touches it
+    src = g_file_new_for_path(SAMPLE_PATH "/no-metadata.jpg");
+    result = g_file_copy(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_save_file(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    saved = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_false(gexiv2_metadata_has_tag(saved, "Exif.Image.Make", &error));
+    g_assert_no_error(error);
+
+    // Changed families are written
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_save_file(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Nobody");
+    g_free(value);
+
+    g_object_unref(src);
+    g_object_unref(dest);
+    g_object_unref(saved);
+    g_object_unref(meta);
+}
+
+static void test_nobug_save_in_place(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* saved = NULL;
+    GExiv2SaveMethod method = GEXIV2_SAVE_METHOD_NONE;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    GFile* src = NULL;
+    GFile* dest = NULL;
+    GString* long_value = NULL;
+    gchar* value = NULL;
+    gchar* contents = NULL;
+    gchar* trailer = NULL;
+    gsize length = 0;
+    gsize saved_length = 0;
+    const char* tmp_file = "save-in-place.jpg";
+    const char* tiff_file = "save-in-place.tif";
+
+    src = g_file_new_for_path(SAMPLE_PATH "/original.jpg");
+    dest = g_file_new_for_path(tmp_file);
+    result = g_file_copy(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_save_file_in_place(meta, tmp_file, &method, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(method, ==, GEXIV2_SAVE_METHOD_NONE);
+
+    // Whatever the first save does, the packet it writes is padded
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.dc.source", "first", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_in_place(meta, tmp_file, &method, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(method, !=, GEXIV2_SAVE_METHOD_NONE);
+
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.dc.source", "second", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_in_place(meta, tmp_file, &method, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(method, ==, GEXIV2_SAVE_METHOD_IN_PLACE);
+
+    saved = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Xmp.dc.source", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "second");
+    g_free(value);
+
+    // More than the padding can take
+    long_value = g_string_new(NULL);
+    while (long_value->len < 16 * 1024)
+        g_string_append(long_value, "lorem ipsum ");
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.dc.source", long_value->str, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_in_place(meta, tmp_file, &method, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(method, ==, GEXIV2_SAVE_METHOD_REWRITE);
+
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Xmp.dc.source", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, long_value->str);
+    g_free(value);
+
+    // The packet of a TIFF file is found through the first IFD, and a trailer written with single
+    // quotes is just as writable
+    result = g_file_get_contents(SAMPLE_PATH "/sample.tif", &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    trailer = g_strrstr_len(contents, length, "<?xpacket end=\"w\"?>");
+    g_assert_nonnull(trailer);
+    trailer[14] = trailer[16] = '\'';
+    result = g_file_set_contents(tiff_file, contents, length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_free(contents);
+
+    result = gexiv2_metadata_open_path(meta, tiff_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_set_tag_string(meta, "Xmp.xmp.Rating", "5", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_in_place(meta, tiff_file, &method, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpint(method, ==, GEXIV2_SAVE_METHOD_IN_PLACE);
+
+    result = g_file_get_contents(tiff_file, &contents, &saved_length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpuint(saved_length, ==, length);
+    g_free(contents);
+
+    result = gexiv2_metadata_open_path(saved, tiff_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Xmp.xmp.Rating", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "5");
+    g_free(value);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Make", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "GExiv2");
+    g_free(value);
+
+    g_string_free(long_value, TRUE);
+    g_object_unref(src);
+    g_object_unref(dest);
+    g_object_unref(saved);
+    g_object_unref(meta);
+}
+
+static void test_nobug_save_to_stream(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* saved = NULL;
+    GOutputStream* stream = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* value = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    stream = g_memory_output_stream_new_resizable();
+    result = gexiv2_metadata_save_to_stream(meta, stream, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = g_output_stream_close(stream, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    saved = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_buf(saved,
+                                      g_memory_output_stream_get_data(G_MEMORY_OUTPUT_STREAM(stream)),
+                                      (glong) g_memory_output_stream_get_data_size(G_MEMORY_OUTPUT_STREAM(stream)),
+                                      &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Nobody");
+    g_free(value);
+    g_object_unref(stream);
+
+    // Without the image data there is nothing to write
+    result = gexiv2_metadata_open_path_metadata_only(meta, SAMPLE_PATH "/original.jpg", NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    stream = g_memory_output_stream_new_resizable();
+    result = gexiv2_metadata_save_to_stream(meta, stream, NULL, &error);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED);
+    g_assert_false(result);
+    g_clear_error(&error);
+
+    g_object_unref(stream);
+    g_object_unref(saved);
+    g_object_unref(meta);
+}
+
+static void test_nobug_as_bytes(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* saved = NULL;
+    GBytes* original = NULL;
+    GBytes* bytes = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+    gchar* value = NULL;
+
+    result = g_file_get_contents(SAMPLE_PATH "/original.jpg", &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    original = g_bytes_new_take(contents, length);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    saved = gexiv2_metadata_new();
+
+    // The results own their data and outlive the metadata they came from
+    bytes = gexiv2_metadata_as_bytes(meta, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(bytes);
+    g_object_unref(meta);
+    meta = NULL;
+
+    result = gexiv2_metadata_open_buf(saved, g_bytes_get_data(bytes, NULL), (glong) g_bytes_get_size(bytes), &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Nobody");
+    g_free(value);
+    g_bytes_unref(bytes);
+
+    result = gexiv2_metadata_set_tag_string(saved, "Exif.Image.Artist", "Somebody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    bytes = gexiv2_metadata_as_bytes(saved, original, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(bytes);
+
+    result = gexiv2_metadata_open_buf(saved, g_bytes_get_data(bytes, NULL), (glong) g_bytes_get_size(bytes), &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Somebody");
+    g_free(value);
+
+    g_bytes_unref(bytes);
+    g_bytes_unref(original);
+    g_object_unref(saved);
+}
+
+static void test_nobug_save_with_flags(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* saved = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    GFile* src = NULL;
+    GFile* dest = NULL;
+    GDir* dir = NULL;
+    const gchar* name = NULL;
+    gchar* value = NULL;
+    gchar* contents = NULL;
+    const char* tmp_file = "save-with-flags.jpg";
+#ifdef G_OS_UNIX
+    GFile* link = NULL;
+    const char* link_file = "save-with-flags-link.jpg";
+#endif
+
+    src = g_file_new_for_path(SAMPLE_PATH "/original.jpg");
+    dest = g_file_new_for_path(tmp_file);
+    result = g_file_copy(src, dest, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_with_flags(meta, tmp_file, GEXIV2_SAVE_NO_SYNC, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Somebody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_with_flags(meta, tmp_file, GEXIV2_SAVE_ATOMIC_RENAME | GEXIV2_SAVE_FULL_SYNC,
+                                                  &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    saved = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Somebody");
+    g_free(value);
+
+#ifdef G_OS_UNIX
+    // Saving through a symbolic link replaces the file it points to and keeps the link
+    g_remove(link_file);
+    link = g_file_new_for_path(link_file);
+    result = g_file_make_symbolic_link(link, tmp_file, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Linked", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_with_flags(meta, link_file, GEXIV2_SAVE_ATOMIC_RENAME, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_true(g_file_test(link_file, G_FILE_TEST_IS_SYMLINK));
+
+    result = gexiv2_metadata_open_path(saved, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    value = gexiv2_metadata_get_tag_string(saved, "Exif.Image.Artist", &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Linked");
+    g_free(value);
+
+    g_remove(link_file);
+    g_object_unref(link);
+#endif
+
+    // A failed save leaves the file as it was
+    result = g_file_set_contents(tmp_file, "Not an image", -1, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_set_tag_string(meta, "Exif.Image.Artist", "Nobody", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_save_file_with_flags(meta, tmp_file, GEXIV2_SAVE_ATOMIC_RENAME, &error);
+    g_assert_nonnull(error);
+    g_assert_false(result);
+    g_clear_error(&error);
+
+    result = g_file_get_contents(tmp_file, &contents, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpstr(contents, ==, "Not an image");
+    g_free(contents);
+
+    // No temporary file is left behind
+    dir = g_dir_open(".", 0, &error);
+    g_assert_no_error(error);
+    while ((name = g_dir_read_name(dir)) != NULL)
+        g_assert_false(g_str_has_prefix(name, "save-with-flags.jpg."));
+    g_dir_close(dir);
+
+    g_object_unref(src);
+    g_object_unref(dest);
+    g_object_unref(saved);
+    g_object_unref(meta);
+}
+
+static void test_nobug_reset(void) {
+    GExiv2Metadata* meta = NULL;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    gchar** tags = NULL;
+    gchar* value = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpstr(gexiv2_metadata_get_mime_type(meta), ==, "image/jpeg");
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_assert_nonnull(tags);
+    g_assert_nonnull(tags[0]);
+    g_strfreev(tags);
+
+    gexiv2_metadata_set_comment(meta, "A comment long enough to need its own buffer", &error);
+    g_assert_no_error(error);
+
+    gexiv2_metadata_reset(meta);
+    g_assert_null(gexiv2_metadata_get_mime_type(meta));
+
+    // The same object reads the next file as if it was new
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/no-metadata.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpstr(gexiv2_metadata_get_mime_type(meta), ==, "image/jpeg");
+
+    tags = gexiv2_metadata_get_exif_tags(meta);
+    g_assert_nonnull(tags);
+    g_assert_null(tags[0]);
+    g_strfreev(tags);
+
+    value = gexiv2_metadata_get_comment(meta, &error);
+    g_assert_no_error(error);
+    g_assert_null(value);
+
+    gexiv2_metadata_set_comment(meta, "Short", &error);
+    g_assert_no_error(error);
+    value = gexiv2_metadata_get_comment(meta, &error);
+    g_assert_no_error(error);
+    g_assert_cmpstr(value, ==, "Short");
+    g_free(value);
+
+    g_object_unref(meta);
+}
+
+static gpointer batch_reader_next_thread(gpointer data) {
+    return gexiv2_batch_reader_next(GEXIV2_BATCH_READER(data));
+}
+
+static void test_nobug_batch_reader(void) {
+    GExiv2BatchReader* reader = NULL;
+    GExiv2BatchResult* result = NULL;
+    GFile* file = NULL;
+    GHashTable* values = NULL;
+    GThread* thread = NULL;
+    const gchar* tags[] = {"Exif.Image.Make", NULL};
+    const gchar* invalid_tags[] = {"Exif.Image.Make", "Exif.Nothing.Here", NULL};
+    gboolean seen[4] = {FALSE, FALSE, FALSE, FALSE};
+    guint count = 0;
+    guint index = 0;
+
+    // One pending result at most, so the workers have to wait for the results to be taken
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_EXIF, tags, 2, 1);
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/no-metadata.jpg");
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/does-not-exist.jpg");
+    file = g_file_new_for_path(SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_add_file(reader, file);
+    g_object_unref(file);
+    gexiv2_batch_reader_close(reader);
+
+    while ((result = gexiv2_batch_reader_next(reader)) != NULL) {
+        index = gexiv2_batch_result_get_index(result);
+        g_assert_cmpuint(index, <, 4);
+        g_assert_false(seen[index]);
+        seen[index] = TRUE;
+        count++;
+
+        g_assert_null(gexiv2_batch_result_get_metadata(result));
+        values = gexiv2_batch_result_get_tags(result);
+
+        if (index == 2) {
+            g_assert_nonnull(gexiv2_batch_result_get_error(result));
+            g_assert_null(values);
+        } else {
+            g_assert_null(gexiv2_batch_result_get_error(result));
+            g_assert_nonnull(values);
+            if (index == 1)
+                g_assert_cmpuint(g_hash_table_size(values), ==, 0);
+            else
+                g_assert_cmpstr(g_hash_table_lookup(values, "Exif.Image.Make"), ==, "NIKON");
+        }
+
+        gexiv2_batch_result_unref(result);
+    }
+    g_assert_cmpuint(count, ==, 4);
+    g_object_unref(reader);
+
+    // Without tags, the whole metadata is handed out
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_ALL, NULL, 0, 0);
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_close(reader);
+
+    result = gexiv2_batch_reader_next(reader);
+    g_assert_nonnull(result);
+    g_assert_cmpstr(gexiv2_batch_result_get_path(result), ==, SAMPLE_PATH "/original.jpg");
+    g_assert_nonnull(gexiv2_batch_result_get_metadata(result));
+    g_assert_cmpstr(gexiv2_metadata_get_mime_type(gexiv2_batch_result_get_metadata(result)), ==, "image/jpeg");
+    gexiv2_batch_result_unref(result);
+    g_assert_null(gexiv2_batch_reader_next(reader));
+    g_object_unref(reader);
+
+    // Invalid tag names are reported with every result
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_EXIF, invalid_tags, 1, 0);
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/no-metadata.jpg");
+    gexiv2_batch_reader_close(reader);
+
+    count = 0;
+    while ((result = gexiv2_batch_reader_next(reader)) != NULL) {
+        g_assert_nonnull(gexiv2_batch_result_get_error(result));
+        g_assert_null(gexiv2_batch_result_get_tags(result));
+        gexiv2_batch_result_unref(result);
+        count++;
+    }
+    g_assert_cmpuint(count, ==, 2);
+    g_object_unref(reader);
+
+    // Closing wakes up a thread already waiting for the next result
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_ALL, NULL, 1, 0);
+    thread = g_thread_new("next", batch_reader_next_thread, reader);
+    g_usleep(G_USEC_PER_SEC / 10);
+    gexiv2_batch_reader_close(reader);
+    g_assert_null(g_thread_join(thread));
+    g_object_unref(reader);
+
+    // Dropping a reader with results that were never taken
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_ALL, NULL, 1, 1);
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/original.jpg");
+    g_object_unref(reader);
+}
+
+static void test_nobug_scanner(void) {
+    GExiv2Scanner* scanner = NULL;
+    GError* error = NULL;
+    gboolean result = FALSE;
+    gchar** paths = NULL;
+    const gchar* tags[] = {"Exif.Image.Make", NULL};
+    const gchar* other_tags[] = {"Exif.Image.Model", NULL};
+    const char* index_file = "scanner.index";
+    gchar* contents = NULL;
+    gsize length = 0;
+    guint files = 0;
+
+    g_remove(index_file);
+
+    scanner = gexiv2_scanner_new(GEXIV2_OPEN_EXIF, tags);
+    result = gexiv2_scanner_load_index(scanner, index_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_scanner_scan(scanner, SAMPLE_PATH, 2, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    files = gexiv2_scanner_get_files_read(scanner);
+    g_assert_cmpuint(files, >, 0);
+    g_assert_cmpuint(gexiv2_scanner_get_files_unchanged(scanner), ==, 0);
+    g_assert_cmpstr(gexiv2_scanner_get_tag_string(scanner, SAMPLE_PATH "/original.jpg", "Exif.Image.Make"), ==, "NIKON");
+    g_assert_null(gexiv2_scanner_get_tag_string(scanner, SAMPLE_PATH "/no-metadata.jpg", "Exif.Image.Make"));
+
+    paths = gexiv2_scanner_get_paths(scanner);
+    g_assert_true(g_strv_contains((const gchar* const*) paths, SAMPLE_PATH "/original.jpg"));
+    g_assert_cmpuint(g_strv_length(paths) + gexiv2_scanner_get_files_failed(scanner), ==, files);
+    g_strfreev(paths);
+
+    result = gexiv2_scanner_save_index(scanner, index_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_object_unref(scanner);
+
+    // Nothing changed, so no file is opened again
+    scanner = gexiv2_scanner_new(GEXIV2_OPEN_EXIF, tags);
+    result = gexiv2_scanner_load_index(scanner, index_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_scanner_scan(scanner, SAMPLE_PATH, 0, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpuint(gexiv2_scanner_get_files_read(scanner), ==, 0);
+    g_assert_cmpuint(gexiv2_scanner_get_files_unchanged(scanner), ==, files);
+    g_assert_cmpstr(gexiv2_scanner_get_tag_string(scanner, SAMPLE_PATH "/original.jpg", "Exif.Image.Make"), ==, "NIKON");
+    g_object_unref(scanner);
+
+    // An index for other tags is not used
+    scanner = gexiv2_scanner_new(GEXIV2_OPEN_EXIF, other_tags);
+    result = gexiv2_scanner_load_index(scanner, index_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_scanner_scan(scanner, SAMPLE_PATH, 0, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpuint(gexiv2_scanner_get_files_read(scanner), ==, files);
+    g_assert_cmpuint(gexiv2_scanner_get_files_unchanged(scanner), ==, 0);
+    g_object_unref(scanner);
+
+    // A truncated index is not used either
+    result = g_file_get_contents(index_file, &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = g_file_set_contents(index_file, contents, (gssize) length - 4, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_free(contents);
+
+    scanner = gexiv2_scanner_new(GEXIV2_OPEN_EXIF, tags);
+    result = gexiv2_scanner_load_index(scanner, index_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    result = gexiv2_scanner_scan(scanner, SAMPLE_PATH, 0, NULL, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_cmpuint(gexiv2_scanner_get_files_read(scanner), ==, files);
+    g_assert_cmpuint(gexiv2_scanner_get_files_unchanged(scanner), ==, 0);
+    g_object_unref(scanner);
+
+    g_remove(index_file);
+}
+
+static gpointer xmp_namespace_worker(gpointer data) {
+    guint id = GPOINTER_TO_UINT(data);
+    GExiv2Metadata* meta = NULL;
+    GError* error = NULL;
+    gchar* name = g_strdup_printf("https://gexiv2.example.org/thread%u/", id);
+    gchar* prefix = g_strdup_printf("thread%u", id);
+    gchar* ns = NULL;
+    gboolean result = FALSE;
+    guint i = 0;
+
+    for (i = 0; i < 50; i++) {
+        result = gexiv2_metadata_register_xmp_namespace(name, prefix, &error);
+        g_assert_no_error(error);
+        g_assert_true(result);
+
+        ns = gexiv2_metadata_get_xmp_namespace_for_tag(prefix, &error);
+        g_assert_no_error(error);
+        g_assert_cmpstr(ns, ==, name);
+        g_free(ns);
+
+        result = gexiv2_metadata_unregister_xmp_namespace(name, &error);
+        g_assert_no_error(error);
+        g_assert_true(result);
+
+        meta = gexiv2_metadata_new();
+        result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/original.jpg", &error);
+        g_assert_no_error(error);
+        g_assert_true(result);
+        g_assert_true(gexiv2_metadata_has_exif(meta));
+        g_object_unref(meta);
+    }
+
+    g_free(name);
+    g_free(prefix);
+
+    return NULL;
+}
+
+static void test_nobug_xmp_namespace_threads(void) {
+    GThread* threads[4];
+    guint i = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(threads); i++)
+        threads[i] = g_thread_new("xmp-namespaces", xmp_namespace_worker, GUINT_TO_POINTER(i));
+
+    for (i = 0; i < G_N_ELEMENTS(threads); i++)
+        g_thread_join(threads[i]);
+}
+
+static guint log_messages = 0;
+
+static void count_log_message(GExiv2LogLevel level, const gchar* msg) {
+    g_assert_cmpint(level, <, GEXIV2_LOG_LEVEL_MUTE);
+    g_assert_nonnull(msg);
+    log_messages++;
+}
+
+// Writes no-metadata.jpg with an XMP segment that is not valid XML to path, which Exiv2 warns
+// about on every read
+static void write_broken_xmp_jpeg(const char* path) {
+    static const char identifier[] = "http://ns.adobe.com/xap/1.0/";
+    static const char packet[] = "<x:xmpmeta xmlns:x=\"adobe:ns:meta/\"><rdf:RDF";
+    GByteArray* data = NULL;
+    GError* error = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+    gsize segment_length = 2 + sizeof(identifier) + sizeof(packet) - 1;
+    guint8 header[4] = {0xff, 0xe1, (guint8) (segment_length >> 8), (guint8) segment_length};
+    gboolean result = FALSE;
+
+    result = g_file_get_contents(SAMPLE_PATH "/no-metadata.jpg", &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    data = g_byte_array_new();
+    g_byte_array_append(data, (const guint8*) contents, 2);
+    g_byte_array_append(data, header, sizeof(header));
+    g_byte_array_append(data, (const guint8*) identifier, sizeof(identifier));
+    g_byte_array_append(data, (const guint8*) packet, sizeof(packet) - 1);
+    g_byte_array_append(data, (const guint8*) contents + 2, length - 2);
+
+    result = g_file_set_contents(path, (const gchar*) data->data, data->len, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    g_byte_array_unref(data);
+    g_free(contents);
+}
+
+static void test_nobug_log_capture(void) {
+    GExiv2Metadata* meta = NULL;
+    GError* error = NULL;
+    guint captured = 0;
+    guint dropped = 0;
+    const char* tmp_file = "log-capture.jpg";
+
+    write_broken_xmp_jpeg(tmp_file);
+
+    gexiv2_log_set_handler(count_log_message);
+    g_assert_true(gexiv2_log_get_handler() == count_log_message);
+
+    // Broken XMP makes Exiv2 complain, nothing reaches the handler until the capture ends
+    log_messages = 0;
+    gexiv2_log_capture_begin(64);
+    meta = gexiv2_metadata_new();
+    gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_clear_error(&error);
+    gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_clear_error(&error);
+    g_assert_cmpuint(log_messages, ==, 0);
+
+    dropped = gexiv2_log_capture_end(NULL);
+    g_assert_cmpuint(dropped, ==, 0);
+    captured = log_messages;
+    g_assert_cmpuint(captured, >, 0);
+
+    // With room for a single message, the others are dropped
+    log_messages = 0;
+    gexiv2_log_capture_begin(1);
+    gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_clear_error(&error);
+    gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_clear_error(&error);
+    dropped = gexiv2_log_capture_end(count_log_message);
+    g_assert_cmpuint(log_messages, ==, 1);
+    g_assert_cmpuint(dropped, ==, captured - 1);
+
+    // Without a capture, the messages go straight to the handler
+    log_messages = 0;
+    gexiv2_metadata_open_path(meta, tmp_file, &error);
+    g_clear_error(&error);
+    g_assert_cmpuint(log_messages, ==, captured / 2);
+
+    g_object_unref(meta);
+    gexiv2_log_use_glib_logging();
+}
+
+static void assert_same_metadata(GExiv2Metadata* expected, GExiv2Metadata* actual) {
+    GExiv2PreviewProperties** expected_props = NULL;
+    GExiv2PreviewProperties** actual_props = NULL;
+    GError* error = NULL;
+    gchar** tags = NULL;
+
+    tags = gexiv2_metadata_get_exif_tags(expected);
+    g_assert_nonnull(tags[0]);
+    for (gchar** tag = tags; *tag != NULL; tag++) {
+        gchar* expected_value = gexiv2_metadata_get_tag_string(expected, *tag, NULL);
+        gchar* actual_value = gexiv2_metadata_get_tag_string(actual, *tag, NULL);
+
+        g_assert_cmpstr(actual_value, ==, expected_value);
+
+        g_free(expected_value);
+        g_free(actual_value);
+    }
+    g_strfreev(tags);
+
+    expected_props = gexiv2_metadata_get_preview_properties(expected);
+    actual_props = gexiv2_metadata_get_preview_properties(actual);
+    g_assert_nonnull(expected_props);
+    g_assert_nonnull(actual_props);
+
+    for (guint i = 0; expected_props[i] != NULL; i++) {
+        GExiv2PreviewImage* expected_image = NULL;
+        GExiv2PreviewImage* actual_image = NULL;
+        const guint8* expected_data = NULL;
+        const guint8* actual_data = NULL;
+        guint32 expected_size = 0;
+        guint32 actual_size = 0;
+
+        g_assert_nonnull(actual_props[i]);
+        expected_image = gexiv2_metadata_get_preview_image(expected, expected_props[i], &error);
+        g_assert_no_error(error);
+        actual_image = gexiv2_metadata_get_preview_image(actual, actual_props[i], &error);
+        g_assert_no_error(error);
+
+        expected_data = gexiv2_preview_image_get_data(expected_image, &expected_size);
+        actual_data = gexiv2_preview_image_get_data(actual_image, &actual_size);
+        g_assert_cmpmem(actual_data, actual_size, expected_data, expected_size);
+
+        g_object_unref(expected_image);
+        g_object_unref(actual_image);
+    }
+}
+
+static void test_nobug_stream_mmap(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2Metadata* stream_meta = NULL;
+    GFile* file = NULL;
+    GFileInputStream* stream = NULL;
+    GInputStream* memory_stream = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+    gboolean result = FALSE;
+    GError* error = NULL;
+
+    meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/sample.tif", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    // Exiv2 decodes TIFF from mmap(), a stream of a local file is mapped directly
+    file = g_file_new_for_path(SAMPLE_PATH "/sample.tif");
+    stream = g_file_read(file, NULL, &error);
+    g_assert_no_error(error);
+
+    stream_meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_from_stream(stream_meta, G_INPUT_STREAM(stream), &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    assert_same_metadata(meta, stream_meta);
+    g_object_unref(stream_meta);
+
+    // Streams without a file descriptor are copied into memory instead
+    result = g_file_get_contents(SAMPLE_PATH "/sample.tif", &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    memory_stream = g_memory_input_stream_new_from_data(contents, (gssize) length, g_free);
+
+    stream_meta = gexiv2_metadata_new();
+    result = gexiv2_metadata_from_stream(stream_meta, memory_stream, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    assert_same_metadata(meta, stream_meta);
+
+    g_object_unref(memory_stream);
+    g_object_unref(stream);
+    g_object_unref(file);
+    g_object_unref(stream_meta);
+    g_object_unref(meta);
+}
+
+static void test_nobug_lazy_previews(void) {
+    GExiv2Metadata* eager = NULL;
+    GExiv2Metadata* lazy = NULL;
+    GExiv2Metadata* without = NULL;
+    GExiv2PreviewProperties** eager_props = NULL;
+    GExiv2PreviewProperties** lazy_props = NULL;
+    GExiv2PreviewImage* image = NULL;
+    gchar* contents = NULL;
+    gsize length = 0;
+    gboolean result = FALSE;
+    GError* error = NULL;
+    const char* tmp_file = "lazy-previews.tif";
+
+    result = g_file_get_contents(SAMPLE_PATH "/sample.tif", &contents, &length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = g_file_set_contents(tmp_file, contents, (gssize) length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    eager = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(eager, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    eager_props = gexiv2_metadata_get_preview_properties(eager);
+    g_assert_nonnull(eager_props);
+
+    lazy = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path(lazy, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+
+    // Previews are only looked for on first access. The reduced resolution image in the SubIFD
+    // is read from the file then, which is gone for the lazy object. The eager one keeps its list.
+    g_assert_cmpint(g_unlink(tmp_file), ==, 0);
+    g_test_expect_message(NULL, G_LOG_LEVEL_WARNING, "Failed to read preview properties*");
+    g_assert_null(gexiv2_metadata_get_preview_properties(lazy));
+    g_test_assert_expected_messages();
+    g_assert_true(gexiv2_metadata_get_preview_properties(eager) == eager_props);
+
+    // Failing once does not make it try again
+    g_assert_null(gexiv2_metadata_get_preview_properties(lazy));
+
+    // With the file restored, the lazily built list matches the eager one
+    result = g_file_set_contents(tmp_file, contents, (gssize) length, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    result = gexiv2_metadata_open_path(lazy, tmp_file, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    lazy_props = gexiv2_metadata_get_preview_properties(lazy);
+    g_assert_nonnull(lazy_props);
+
+    for (guint i = 0; eager_props[i] != NULL; i++) {
+        g_assert_nonnull(lazy_props[i]);
+        g_assert_cmpstr(gexiv2_preview_properties_get_mime_type(lazy_props[i]), ==,
+                        gexiv2_preview_properties_get_mime_type(eager_props[i]));
+        g_assert_cmpuint(gexiv2_preview_properties_get_size(lazy_props[i]), ==,
+                         gexiv2_preview_properties_get_size(eager_props[i]));
+        g_assert_cmpuint(gexiv2_preview_properties_get_width(lazy_props[i]), ==,
+                         gexiv2_preview_properties_get_width(eager_props[i]));
+        g_assert_cmpuint(gexiv2_preview_properties_get_height(lazy_props[i]), ==,
+                         gexiv2_preview_properties_get_height(eager_props[i]));
+    }
+
+    // Previews that were not asked for are neither listed nor handed out
+    without = gexiv2_metadata_new();
+    result = gexiv2_metadata_open_path_with_flags(without, tmp_file, GEXIV2_OPEN_EXIF, &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_null(gexiv2_metadata_get_preview_properties(without));
+
+    image = gexiv2_metadata_get_preview_image(without, eager_props[0], &error);
+    g_assert_error(error, g_quark_from_string("GExiv2"), 501);
+    g_assert_null(image);
+    g_clear_error(&error);
+
+    // Opening another file drops the list of the previous one
+    result = gexiv2_metadata_open_path(lazy, SAMPLE_PATH "/no-metadata.jpg", &error);
+    g_assert_no_error(error);
+    g_assert_true(result);
+    g_assert_null(gexiv2_metadata_get_preview_properties(lazy));
+
+    g_free(contents);
+    g_object_unref(without);
+    g_object_unref(lazy);
+    g_object_unref(eager);
+}
+
+static void test_nobug_xmp_before_batch_reader(void) {
+    GExiv2Metadata* meta = NULL;
+    GExiv2BatchReader* reader = NULL;
+    GExiv2BatchResult* result = NULL;
+    GHashTable* values = NULL;
+    GError* error = NULL;
+    const gchar* tags[] = {"Xmp.xmp.Rating", NULL};
+    gboolean success = FALSE;
+    guint count = 0;
+    guint i = 0;
+
+    // Runs without gexiv2_initialize(), see main()
+    if (!g_test_subprocess()) {
+        g_test_trap_subprocess(NULL, 0, 0);
+        g_test_trap_assert_passed();
+        return;
+    }
+
+    // XMP is decoded before anything sets up the lock of the XMP toolkit
+    meta = gexiv2_metadata_new();
+    success = gexiv2_metadata_open_path(meta, SAMPLE_PATH "/sample.tif", &error);
+    g_assert_no_error(error);
+    g_assert_true(success);
+    g_assert_true(gexiv2_metadata_has_xmp(meta));
+    g_object_unref(meta);
+
+    reader = gexiv2_batch_reader_new(GEXIV2_OPEN_XMP, tags, 4, 0);
+    for (i = 0; i < 64; i++)
+        gexiv2_batch_reader_add_path(reader, SAMPLE_PATH "/sample.tif");
+    gexiv2_batch_reader_close(reader);
+
+    while ((result = gexiv2_batch_reader_next(reader)) != NULL) {
+        g_assert_null(gexiv2_batch_result_get_error(result));
+        values = gexiv2_batch_result_get_tags(result);
+        g_assert_nonnull(values);
+        g_assert_cmpstr(g_hash_table_lookup(values, "Xmp.xmp.Rating"), ==, "3");
+        gexiv2_batch_result_unref(result);
+        count++;
+    }
+    g_assert_cmpuint(count, ==, 64);
+    g_object_unref(reader);
+}
+
 static void test_ggo_80() {
     GExiv2Metadata* meta = NULL;
     gboolean result = FALSE;
@@ -650,9 +2486,12 @@ static void test_ggo_80() {
 
 int main(int argc, char *argv[static argc + 1])
 {
-    gexiv2_initialize();
-
     g_test_init(&argc, &argv, NULL);
+
+    // Subprocesses stand in for applications that never call it
+    if (!g_test_subprocess())
+        gexiv2_initialize();
+
     g_test_add_func("/bugs/gnome/775249", test_bgo_775249);
     g_test_add_func("/bugs/gnome/730136", test_bgo_730136);
     g_test_add_func("/bugs/gnome/792239", test_bgo_792239);
@@ -671,6 +2510,32 @@ int main(int argc, char *argv[static argc + 1])
     g_test_add_func("/bugs/gnome/gitlab/86", test_ggo_80);
     g_test_add_func("/bugs/gnome/gitlab/87", test_ggo_87);
     g_test_add_func("/bugs/gnome/nobug/01", test_nobug_gps);
+    g_test_add_func("/bugs/gnome/nobug/02", test_nobug_open_async);
+    g_test_add_func("/bugs/gnome/nobug/03", test_nobug_save_async);
+    g_test_add_func("/bugs/gnome/nobug/04", test_nobug_from_stream);
+    g_test_add_func("/bugs/gnome/nobug/05", test_nobug_metadata_only);
+    g_test_add_func("/bugs/gnome/nobug/06", test_nobug_open_flags);
+    g_test_add_func("/bugs/gnome/nobug/07", test_nobug_tag_index);
+    g_test_add_func("/bugs/gnome/nobug/08", test_nobug_tag_id);
+    g_test_add_func("/bugs/gnome/nobug/09", test_nobug_tags_batch);
+    g_test_add_func("/bugs/gnome/nobug/10", test_nobug_snapshot);
+    g_test_add_func("/bugs/gnome/nobug/11", test_nobug_tag_lists);
+    g_test_add_func("/bugs/gnome/nobug/12", test_nobug_tag_iter);
+    g_test_add_func("/bugs/gnome/nobug/13", test_nobug_metadata_batch);
+    g_test_add_func("/bugs/gnome/nobug/14", test_nobug_save_unchanged);
+    g_test_add_func("/bugs/gnome/nobug/15", test_nobug_save_in_place);
+    g_test_add_func("/bugs/gnome/nobug/16", test_nobug_save_to_stream);
+    g_test_add_func("/bugs/gnome/nobug/17", test_nobug_as_bytes);
+    g_test_add_func("/bugs/gnome/nobug/18", test_nobug_save_with_flags);
+    g_test_add_func("/bugs/gnome/nobug/19", test_nobug_reset);
+    g_test_add_func("/bugs/gnome/nobug/20", test_nobug_batch_reader);
+    g_test_add_func("/bugs/gnome/nobug/21", test_nobug_scanner);
+    g_test_add_func("/bugs/gnome/nobug/22", test_nobug_xmp_namespace_threads);
+    g_test_add_func("/bugs/gnome/nobug/23", test_nobug_log_capture);
+    g_test_add_func("/bugs/gnome/nobug/24", test_nobug_stream_mmap);
+    g_test_add_func("/bugs/gnome/nobug/25", test_nobug_open_flags_formats);
+    g_test_add_func("/bugs/gnome/nobug/26", test_nobug_lazy_previews);
+    g_test_add_func("/bugs/gnome/nobug/27", test_nobug_xmp_before_batch_reader);
 
     int result = g_test_run();
 
@@ -0,0 +1,104 @@
+/*
+ * gexiv2-scan.vala
+ *
+ * This is free software. See COPYING for details.
+ */
+
+// Global variables used in parsing program parameters
+[CCode (array_length = false, array_null_terminated = true)]
+string[] scan_tags;
+string index_file;
+int max_threads = 0;
+bool print_values = false;
+
+// Command line optional parameters
+const GLib.OptionEntry[] options = {
+    // [-tag TAG]
+    {"tag", 't', 0, OptionArg.STRING_ARRAY, ref scan_tags, "Index TAG, may be given more than once", "TAG"},
+
+    // [-index FILE]
+    {"index", 'i', 0, OptionArg.FILENAME, ref index_file, "Keep the index in FILE, so unchanged files are not read again", "FILE"},
+
+    // [-jobs N]
+    {"jobs", 'j', 0, OptionArg.INT, ref max_threads, "Read N files at once (default: one per processor)", "N"},
+
+    // [-print]
+    {"print", 'p', 0, OptionArg.NONE, ref print_values, "Print the indexed values of every file", null},
+
+    // list terminator
+    {null}
+};
+
+/**
+ * main:
+ * @args: Program arguments
+ *
+ * Indexes tags of all files below a directory, reading only the files that changed since
+ * the last run.
+ *
+ * Returns: 0 for success or error code
+ */
+int main(string[] args) {
+    var program_name = Path.get_basename(args[0]);
+
+    GExiv2.initialize();
+
+    try {
+        var opt_context = new OptionContext("DIRECTORY");
+        opt_context.set_summary("Indexes metadata tags of all files below DIRECTORY.");
+        opt_context.set_description("Example:\n  " + program_name +
+                                    " -i photos.index -t Exif.Image.Make -t Xmp.dc.subject ~/Pictures\n");
+        opt_context.set_help_enabled(true);
+        opt_context.add_main_entries(options, null);
+        opt_context.parse(ref args);
+
+        if (args.length != 2 || scan_tags == null || scan_tags.length == 0 || max_threads < 0) {
+            printerr("%s error: Invalid parameters\n", program_name);
+            print(opt_context.get_help(true, null));
+            return 1;
+        }
+
+        // Only decode the families the tags belong to
+        GExiv2.OpenFlags flags = 0;
+        foreach (var tag in scan_tags) {
+            if (tag.has_prefix("Exif."))
+                flags |= GExiv2.OpenFlags.EXIF;
+            else if (tag.has_prefix("Xmp."))
+                flags |= GExiv2.OpenFlags.XMP;
+            else if (tag.has_prefix("Iptc."))
+                flags |= GExiv2.OpenFlags.IPTC;
+            else
+                throw new GLib.Error(Quark.from_string(program_name), 1, "Invalid tag `%s'", tag);
+        }
+
+        var scanner = new GExiv2.Scanner(flags, scan_tags);
+        if (index_file != null)
+            scanner.load_index(index_file);
+
+        var timer = new Timer();
+        scanner.scan(args[1], (uint) max_threads, null);
+        timer.stop();
+
+        if (index_file != null)
+            scanner.save_index(index_file);
+
+        if (print_values) {
+            foreach (var path in scanner.get_paths()) {
+                print("%s\n", path);
+                foreach (var tag in scan_tags) {
+                    var value = scanner.get_tag_string(path, tag);
+                    if (value != null)
+                        print("    %-40s %s\n", tag, value);
+                }
+            }
+        }
+
+        print("%u read, %u unchanged, %u unreadable in %.2fs\n", scanner.get_files_read(),
+              scanner.get_files_unchanged(), scanner.get_files_failed(), timer.elapsed());
+    } catch (Error e) {
+        printerr("%s error: %s\n", program_name, e.message);
+        return 1;
+    }
+
+    return 0;
+}